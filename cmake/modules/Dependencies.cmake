@@ -1,10 +1,11 @@
 include(MacroLogFeature)
 
-find_package(Qt4 4.8.0 COMPONENTS QtCore QtGui QtSql)
+find_package(Qt4 4.8.0 COMPONENTS QtCore QtGui QtSql QtTest)
 macro_log_feature(QT4_FOUND "Qt 4" "Qt 4 framework" "http://qt-project.org/" TRUE 4.8.0)
 
-find_package(LibUSB 1.0)
-macro_log_feature(LIBUSB_FOUND "libusb" "Userspace access to USB devices" "http://libusb.sourceforge.net" TRUE 1.0)
+# libusb_interrupt_event_handler() is available since 1.0.21
+find_package(LibUSB 1.0.21)
+macro_log_feature(LIBUSB_FOUND "libusb" "Userspace access to USB devices" "http://libusb.sourceforge.net" TRUE 1.0.21)
 
 find_package(Doxygen)
 macro_log_feature(DOXYGEN_FOUND "Doxygen" "Documentation system" "http://www.doxygen.org/" FALSE)
@@ -26,8 +26,13 @@
 
 #include <Usb/UsbDownloader.hpp>
 #include <Usb/UsbData.hpp>
+#include <Data/RawImageDB.hpp>
+#include <Data/DbWorker.hpp>
 #include <Data/Models/UserDataModel.hpp>
 #include <Data/Models/UserMeasurementModel.hpp>
+#include <Data/Models/MeasurementRollupModel.hpp>
+
+#include <utils.hpp>
 
 #include <QtCore/QDebug>
 #include <QtGui/QMessageBox>
@@ -38,57 +43,104 @@ namespace BSM {
 BeurerScaleManager::BeurerScaleManager(QWidget* parent, Qt::WindowFlags f)
     : QWidget(parent, f)
     , usb(new Usb::UsbDownloader(this))
-    , usb_data(new Usb::UsbData(this))
+    , db_worker(new Data::DbWorker(this))
 {
     setWindowTitle("Beurer Scale Manager");
 
     ui = new Ui::BeurerScaleManager();
     ui->setupUi(this);
 
+    connect(usb, SIGNAL(downloadStarted()), this, SLOT(downloadStarted()));
     connect(usb, SIGNAL(progress(int)), ui->progressDownload, SLOT(setValue(int)));
-    connect(usb, SIGNAL(completed(QByteArray)), this, SLOT(downloadCompleted(QByteArray)));
+    connect(usb, SIGNAL(deviceReceived(QString,QByteArray)), this, SLOT(downloadReceived(QString,QByteArray)));
+    connect(usb, SIGNAL(deviceCompleted(QString,QByteArray)), this, SLOT(downloadCompleted(QString,QByteArray)));
     connect(usb, SIGNAL(error()), this, SLOT(downloadError()));
+    connect(usb, SIGNAL(downloadFinished()), this, SLOT(downloadFinished()));
+    connect(db_worker, SIGNAL(written(int)), this, SLOT(dbWritten()));
+    connect(db_worker, SIGNAL(failed(int)), this, SLOT(dbFailed()));
+    db_worker->start();
+
+    ui->comboView->addItem(tr("All measurements"), AllMeasurements);
+    ui->comboView->addItem(tr("Last month"), LastMonth);
+    ui->comboView->addItem(tr("Last year"), LastYear);
+    ui->comboView->addItem(tr("Weekly averages"), WeeklyAverages);
+    ui->comboView->addItem(tr("Monthly averages"), MonthlyAverages);
+    ui->comboView->addItem(tr("Quarterly averages"), QuarterlyAverages);
+    ui->comboView->addItem(tr("Yearly averages"), YearlyAverages);
 
     users = Data::UserDataDB::loadAll();
     ui->comboUser->setModel(new Data::Models::UserDataModel(users, this));
     ui->comboUser->setEnabled(true);
+
+    // Download all the scales connected, unless the configuration asks for the first one only
+    usb->setMode(Utils::getDownloadAllDevices() ? Usb::UsbDownloader::AllDevices : Usb::UsbDownloader::FirstDevice);
+    // Download as soon as a scale is plugged in
+    usb->setAutoDownload(true);
+    usb->start();
 }
 
 BeurerScaleManager::~BeurerScaleManager()
 {}
 
 void BeurerScaleManager::startDownload()
+{
+    usb->requestDownload();
+}
+
+void BeurerScaleManager::downloadStarted()
 {
     qDebug() << "START download";
     ui->btnStartDownload->setDisabled(true);
     ui->progressDownload->setValue(0);
     ui->tableMeasurements->setDisabled(true);
 
+    // The data of each scale are parsed while they are received, see scaleData()
+    qDeleteAll(usb_data);
+    usb_data.clear();
+    usb_stale.clear();
+
     // Clear tableMeasurements
     QAbstractItemModel* oldModel = ui->tableMeasurements->model();
     ui->tableMeasurements->setModel(0);
     delete oldModel;
+}
 
-    usb->start();
+void BeurerScaleManager::downloadReceived(const QString& device, const QByteArray& chunk)
+{
+    scaleData(device)->feed(chunk);
 }
 
-void BeurerScaleManager::downloadCompleted(const QByteArray& data)
+void BeurerScaleManager::downloadCompleted(const QString& device, const QByteArray& data)
 {
-    qDebug() << "END download";
-    ui->btnStartDownload->setEnabled(true);
+    qDebug() << "Data received:" << data.size() << "bytes from" << device;
 
-    qDebug() << "Data received:" << data.size() << "bytes";
+    // The users were read again from the DB during the download: parse again with their cursors
+    if (usb_stale.remove(device))
+        delete usb_data.take(device);
+    Usb::UsbData* usbData = scaleData(device);
 
-    if (usb_data->parse(data)) {
-        qDebug() << "Parsed" << usb_data->getUserData().size() << "users";
-        qDebug() << "Scale date and time is" << usb_data->getDateTime();
+    // Nothing to merge if the scale has the same content of a recent download
+    quint64 hash = usbData->imageHash(data);
+    if (Data::RawImageDB::isRecent(device, hash)) {
+        qDebug() << "Scale data not changed since the last download";
+        return;
+    }
+
+    if (usbData->isCompleted() || usbData->parse(data)) {
+        qDebug() << "Parsed" << usbData->getUserData().size() << "changed users";
+        qDebug() << "Scale date and time is" << usbData->getDateTime();
 
-        foreach(Data::UserData* user, usb_data->getUserData()) {
+        // The image and all the users are written by the worker in a single transaction
+        if (!Data::DbWorker::beginBatch())
+            qWarning() << "Cannot start the transaction for the download";
+        Data::RawImageDB::archive(device, hash, QDateTime::currentDateTime(), data);
+
+        foreach(Data::UserData* user, usbData->getUserData()) {
             bool found = false;
             foreach(Data::UserDataDB* userDB, users) {
                 if (user->getId() == userDB->getId()) {
                     found = true;
-                    userDB->merge(usb_data->getDateTime(), *user);
+                    userDB->merge(usbData->getDateTime(), *user);
                     break;
                 }
             }
@@ -124,7 +176,7 @@ void BeurerScaleManager::downloadCompleted(const QByteArray& data)
                         userDB->setHeight(user->getHeight());
                         userDB->setGender(user->getGender());
                         userDB->setActivity(user->getActivity());
-                        if (userDB->merge(usb_data->getDateTime(), *user)) {
+                        if (userDB->merge(usbData->getDateTime(), *user)) {
                             Data::UserDataDBList::iterator it = users.begin();
                             Data::UserDataDBList::iterator itEnd = users.end();
                             while (it != itEnd) {
@@ -141,31 +193,22 @@ void BeurerScaleManager::downloadCompleted(const QByteArray& data)
                 }
             }
         }
-        int currentId = -1;
-        if (ui->comboUser->currentIndex() >= 0) {
-            Data::UserDataDB* userData = static_cast<Data::UserDataDB*>(ui->comboUser->model()->index(ui->comboUser->currentIndex(), 0).internalPointer());
-            if (userData)
-                currentId = userData->getId();
-        }
-        QAbstractItemModel* oldModel = ui->comboUser->model();
-        ui->comboUser->setModel(new Data::Models::UserDataModel(users, this));
-        delete oldModel;
-        if (currentId >= 0) {
-            QAbstractItemModel* model = ui->comboUser->model();
-            for (int i = 0; i < model->rowCount(); ++i) {
-                Data::UserDataDB* userData = static_cast<Data::UserDataDB*>(model->index(i, 0).internalPointer());
-                if (userData && userData->getId() == currentId) {
-                    ui->comboUser->setCurrentIndex(i);
-                    break;
-                }
-            }
+        if (Data::DbWorker::endBatch()) {
+            // The next data of the scale are parsed against this image and the new cursors,
+            // even before the worker writes them on the DB
+            usb_previous.insert(device, data);
+            prepareScaleData(device, usbData);
         }
+        else
+            qCritical() << "Cannot commit the transaction for the download";
 
-        int diffTime = usb_data->getDateTime().secsTo(QDateTime::currentDateTime());
+        updateUsers();
+
+        int diffTime = usbData->getDateTime().secsTo(QDateTime::currentDateTime());
         if (diffTime < -300 || diffTime > 300) {
             QMessageBox::warning(this,
                                  windowTitle() + " - " + tr("Wrong scale settings"),
-                                 tr("The date and time set in the scale (%1) are not correct!").arg(usb_data->getDateTime().toString(Qt::SystemLocaleShortDate))
+                                 tr("The date and time set in the scale (%1) are not correct!").arg(usbData->getDateTime().toString(Qt::SystemLocaleShortDate))
                                     + "<br><br>"
                                     + tr("Please check the settings.")
             );
@@ -176,7 +219,6 @@ void BeurerScaleManager::downloadCompleted(const QByteArray& data)
 void BeurerScaleManager::downloadError()
 {
     qDebug() << "ERROR download";
-    ui->btnStartDownload->setEnabled(true);
 
     QMessageBox::critical(this,
                          windowTitle() + " - " + tr("Download error"),
@@ -184,6 +226,71 @@ void BeurerScaleManager::downloadError()
     );
 }
 
+void BeurerScaleManager::downloadFinished()
+{
+    qDebug() << "END download";
+    ui->btnStartDownload->setEnabled(true);
+
+    // Drop the counts of the new measurements shown while parsing
+    updateUsers();
+
+    // Show again the measurements cleared at the start of the download
+    if (ui->comboUser->currentIndex() >= 0)
+        selectUser(ui->comboUser->currentIndex());
+}
+
+void BeurerScaleManager::userParsed(BSM::Data::UserData* user)
+{
+    // The model of the combo box is replaced when the users change
+    static_cast<Data::Models::UserDataModel*>(ui->comboUser->model())->userParsed(user);
+}
+
+Usb::UsbData* BeurerScaleManager::scaleData(const QString& device)
+{
+    QHash<QString, Usb::UsbData*>::iterator it = usb_data.find(device);
+    if (it != usb_data.end())
+        return *it;
+
+    Usb::UsbData* usbData = new Usb::UsbData(this);
+    connect(usbData, SIGNAL(userParsed(BSM::Data::UserData*)), this, SLOT(userParsed(BSM::Data::UserData*)));
+    prepareScaleData(device, usbData);
+    usb_data.insert(device, usbData);
+    return usbData;
+}
+
+void BeurerScaleManager::prepareScaleData(const QString& device, Usb::UsbData* usbData)
+{
+    // Parse only the users changed since the last image of the scale, and only the samples after the last download
+    QHash<QString, QByteArray>::const_iterator it = usb_previous.find(device);
+    usbData->setPrevious(it != usb_previous.end() ? *it : Data::RawImageDB::loadLast(device));
+    usbData->clearCursors();
+    foreach(Data::UserDataDB* userDB, users)
+        usbData->setCursor(userDB->getId(), userDB->getCursor());
+}
+
+void BeurerScaleManager::updateUsers()
+{
+    int currentId = -1;
+    if (ui->comboUser->currentIndex() >= 0) {
+        Data::UserDataDB* userData = static_cast<Data::UserDataDB*>(ui->comboUser->model()->index(ui->comboUser->currentIndex(), 0).internalPointer());
+        if (userData)
+            currentId = userData->getId();
+    }
+    QAbstractItemModel* oldModel = ui->comboUser->model();
+    ui->comboUser->setModel(new Data::Models::UserDataModel(users, this));
+    delete oldModel;
+    if (currentId >= 0) {
+        QAbstractItemModel* model = ui->comboUser->model();
+        for (int i = 0; i < model->rowCount(); ++i) {
+            Data::UserDataDB* userData = static_cast<Data::UserDataDB*>(model->index(i, 0).internalPointer());
+            if (userData && userData->getId() == currentId) {
+                ui->comboUser->setCurrentIndex(i);
+                break;
+            }
+        }
+    }
+}
+
 void BeurerScaleManager::selectUser(const int index)
 {
     Data::UserDataDB* userData = static_cast<Data::UserDataDB*>(ui->comboUser->model()->index(index, 0).internalPointer());
@@ -191,11 +298,75 @@ void BeurerScaleManager::selectUser(const int index)
         return;
 
     QAbstractItemModel* oldModel = ui->tableMeasurements->model();
-    ui->tableMeasurements->setModel(new Data::Models::UserMeasurementModel(userData->getMeasurements(), userData));
+    ui->tableMeasurements->setModel(measurementModel(userData));
     delete oldModel;
 
+    // The newest measurement is the first one, the older ones are loaded while scrolling
     ui->tableMeasurements->setEnabled(true);
-    ui->tableMeasurements->selectRow(userData->getMeasurements().size() - 1);
+    ui->tableMeasurements->selectRow(0);
+}
+
+void BeurerScaleManager::selectView(const int index)
+{
+    // The measurements are shown again at the end of a download
+    if (index >= 0 && ui->btnStartDownload->isEnabled() && ui->comboUser->currentIndex() >= 0)
+        selectUser(ui->comboUser->currentIndex());
+}
+
+QAbstractItemModel* BeurerScaleManager::measurementModel(Data::UserDataDB* userData) const
+{
+    QDateTime now = QDateTime::currentDateTime();
+    switch (ui->comboView->itemData(ui->comboView->currentIndex()).toInt()) {
+        case LastMonth:
+            return new Data::Models::UserMeasurementModel(userData->getId(), Data::Timestamp::fromDateTime(now.addMonths(-1)), Data::Timestamp(), userData);
+        case LastYear:
+            return new Data::Models::UserMeasurementModel(userData->getId(), Data::Timestamp::fromDateTime(now.addYears(-1)), Data::Timestamp(), userData);
+        case WeeklyAverages:
+            return new Data::Models::MeasurementRollupModel(userData->getId(), Data::MeasurementRollupDB::Week, Data::Timestamp(), Data::Timestamp(), userData);
+        case MonthlyAverages:
+            return new Data::Models::MeasurementRollupModel(userData->getId(), Data::MeasurementRollupDB::Month, Data::Timestamp(), Data::Timestamp(), userData);
+        case QuarterlyAverages:
+            return new Data::Models::MeasurementRollupModel(userData->getId(), Data::MeasurementRollupDB::Quarter, Data::Timestamp(), Data::Timestamp(), userData);
+        case YearlyAverages:
+            return new Data::Models::MeasurementRollupModel(userData->getId(), Data::MeasurementRollupDB::Year, Data::Timestamp(), Data::Timestamp(), userData);
+        default:
+            return new Data::Models::UserMeasurementModel(userData->getId(), userData);
+    }
+}
+
+void BeurerScaleManager::dbWritten()
+{
+    // Show the new measurements, unless a download is in progress
+    if (ui->btnStartDownload->isEnabled() && ui->comboUser->currentIndex() >= 0)
+        selectUser(ui->comboUser->currentIndex());
+}
+
+void BeurerScaleManager::dbFailed()
+{
+    // The transaction was rolled back: drop the cursors, the last downloads and the
+    // recent images already applied in memory, and read them again from the DB
+    Data::RawImageDB::clearRecent();
+    usb_previous.clear();
+
+    QAbstractItemModel* oldModel = ui->tableMeasurements->model();
+    ui->tableMeasurements->setModel(0);
+    delete oldModel;
+
+    Data::UserDataDBList oldUsers = users;
+    users = Data::UserDataDB::loadAll();
+    updateUsers();
+    qDeleteAll(oldUsers);
+
+    // The scales of a download in progress are parsing with the dropped cursors
+    if (!ui->btnStartDownload->isEnabled())
+        usb_stale = QSet<QString>::fromList(usb_data.keys());
+    else if (ui->comboUser->currentIndex() >= 0)
+        selectUser(ui->comboUser->currentIndex());
+
+    QMessageBox::critical(this,
+                          windowTitle() + " - " + tr("Database error"),
+                          tr("The downloaded data cannot be saved in the database!<br><br>Please check the disk and download again.")
+    );
 }
 
 } // namespace BSM
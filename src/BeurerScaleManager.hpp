@@ -28,6 +28,10 @@
 
 #include <Data/UserDataDB.hpp>
 
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QAbstractItemModel>
+
 namespace Ui {
     class BeurerScaleManager;
 }
@@ -39,6 +43,10 @@ namespace Usb {
     class UsbData;
 }
 
+namespace Data {
+    class DbWorker;
+}
+
 /*!
  * \class BSM::BeurerScaleManager
  * \brief QWidget for the main window.
@@ -60,24 +68,80 @@ public:
 protected slots:
     //! The "Start download" button was clicked.
     void startDownload();
-    //! The download was completed.
-    void downloadCompleted(const QByteArray& data);
+    //! A download was started, by the user or by plugging in the scale.
+    void downloadStarted();
+    //! Some data were received from a scale.
+    void downloadReceived(const QString& device, const QByteArray& chunk);
+    //! The download from a scale was completed.
+    void downloadCompleted(const QString& device, const QByteArray& data);
     //! The download was not completed for an error.
     void downloadError();
+    //! The download of all the scales is finished.
+    void downloadFinished();
+    //! A user was parsed from the data of a scale, before the download is completed.
+    void userParsed(BSM::Data::UserData* user);
 
     //! A user was selected in the combo box.
     void selectUser(const int index);
+    //! A view of the measurements was selected in the combo box.
+    void selectView(const int index);
+
+    //! Some writes to the DB were completed.
+    void dbWritten();
+    //! Some writes to the DB failed.
+    void dbFailed();
 
 protected:
+    //! The views of the measurements, in the combo box
+    enum MeasurementView {
+        AllMeasurements,    //!< All the measurements, loaded while scrolling
+        LastMonth,          //!< The measurements of the last month
+        LastYear,           //!< The measurements of the last year
+        WeeklyAverages,     //!< The averages of the measurements by week
+        MonthlyAverages,    //!< The averages of the measurements by month
+        QuarterlyAverages,  //!< The averages of the measurements by quarter of year
+        YearlyAverages      //!< The averages of the measurements by year
+    };
+
+    /*! Create the model of the measurements of a user, for the selected view.
+     * \param userData the user
+     * \return the model, owned by the user
+     */
+    QAbstractItemModel* measurementModel(Data::UserDataDB* userData) const;
+
+    /*! Get the parser of the data of a scale, created at the first data received.
+     * \param device the identifier of the scale
+     * \return the parser of the current download of the scale
+     */
+    Usb::UsbData* scaleData(const QString& device);
+
+    /*! Set the previous image and the cursors of the users to the parser of a scale.
+     * \param device the identifier of the scale
+     * \param usbData the parser of the data of the scale
+     */
+    void prepareScaleData(const QString& device, Usb::UsbData* usbData);
+
+    //! Show the users in the combo box, keeping the selected one.
+    void updateUsers();
+
     //! The UsbDownloader object.
     Usb::UsbDownloader* usb;
 
-    //! The UsbData object.
-    Usb::UsbData* usb_data;
+    //! The parsers of the current download, one for each scale
+    QHash<QString, Usb::UsbData*> usb_data;
+
+    //! The thread that writes the DB.
+    Data::DbWorker* db_worker;
 
     //! The list of users from the DB
     Data::UserDataDBList users;
 
+    //! The scales parsed with the cursors dropped by a DB failure, to parse again
+    QSet<QString> usb_stale;
+
+    //! The last image merged for each scale, maybe not written on the DB yet
+    QHash<QString, QByteArray> usb_previous;
+
 private:
     Ui::BeurerScaleManager* ui;
 };
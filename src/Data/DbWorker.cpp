@@ -0,0 +1,226 @@
+/*!
+ * \file DbWorker.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the DbJob and DbWorker classes
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DbWorker.hpp"
+
+#include <utils.hpp>
+
+#include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
+#include <QtSql/QSqlQuery>
+
+namespace BSM {
+namespace Data {
+
+DbJob::DbJob(const QString& name, const QString& sql, const bool batch)
+    : m_name(name)
+    , m_sql(sql)
+    , m_batch(batch)
+{
+}
+
+void DbJob::bindValue(const QString& placeholder, const QVariant& value)
+{
+    m_values.append(qMakePair(placeholder, value));
+}
+
+bool DbJob::run() const
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, m_sql)) {
+        qCritical() << "Cannot prepare query for" << m_name;
+        return false;
+    }
+    for (int i = 0; i < m_values.size(); ++i)
+        query.bindValue(m_values.at(i).first, m_values.at(i).second);
+    if (!(m_batch ? query.execBatch() : query.exec())) {
+        qCritical() << "Cannot execute query for" << m_name;
+        return false;
+    }
+    query.finish();
+
+    return true;
+}
+
+DbWorker* DbWorker::instance = 0;
+
+//! Depth of the batches executed without a worker, by the caller
+static int directBatchDepth = 0;
+
+DbWorker::DbWorker(QObject* parent)
+    : QThread(parent)
+    , m_batchDepth(0)
+    , m_stop(false)
+{
+    if (instance)
+        qWarning() << "A DbWorker already exists, the new one replaces it";
+    instance = this;
+}
+
+DbWorker::~DbWorker()
+{
+    if (isRunning()) {
+        stop();
+        wait();
+    }
+
+    if (instance == this)
+        instance = 0;
+}
+
+DbWorker* DbWorker::getInstance()
+{
+    return instance;
+}
+
+bool DbWorker::submit(const DbJob& job)
+{
+    if (instance) {
+        QMutexLocker locker(&instance->m_mutex);
+        if (!instance->m_stop) {
+            instance->m_jobs.append(job);
+            instance->m_condition.wakeOne();
+            return true;
+        }
+    }
+
+    // No worker, write now
+    return job.run();
+}
+
+bool DbWorker::beginBatch()
+{
+    if (instance) {
+        QMutexLocker locker(&instance->m_mutex);
+        if (!instance->m_stop) {
+            ++instance->m_batchDepth;
+            return true;
+        }
+    }
+
+    if (directBatchDepth > 0 || Utils::database().transaction()) {
+        ++directBatchDepth;
+        return true;
+    }
+    qCritical() << "Cannot start the transaction";
+    return false;
+}
+
+bool DbWorker::endBatch()
+{
+    if (instance) {
+        QMutexLocker locker(&instance->m_mutex);
+        if (!instance->m_stop || instance->m_batchDepth > 0) {
+            if (instance->m_batchDepth > 0 && --instance->m_batchDepth == 0)
+                instance->m_condition.wakeOne();
+            return true;
+        }
+    }
+
+    if (directBatchDepth == 0) {
+        qWarning() << "No batch to end";
+        return false;
+    }
+    if (--directBatchDepth > 0)
+        return true;
+    if (!Utils::database().commit()) {
+        qCritical() << "Cannot commit the transaction";
+        return false;
+    }
+    return true;
+}
+
+void DbWorker::stop()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = true;
+    m_condition.wakeOne();
+}
+
+void DbWorker::run()
+{
+    // The connection of the thread is the only one that writes
+    if (!Utils::database().isOpen()) {
+        qCritical() << "The DB worker cannot start, the writes are executed by the callers";
+        int pending;
+        {
+            QMutexLocker locker(&m_mutex);
+            m_stop = true;
+            pending = m_jobs.size();
+            m_jobs.clear();
+        }
+        if (pending > 0)
+            emit failed(pending);
+        Utils::releaseConnections();
+        return;
+    }
+
+    forever {
+        QList<DbJob> jobs;
+        {
+            QMutexLocker locker(&m_mutex);
+            // A batch still open when stopping is written anyway
+            while (!m_stop && (m_jobs.isEmpty() || m_batchDepth > 0))
+                m_condition.wait(&m_mutex);
+            if (m_jobs.isEmpty())
+                break;
+            jobs = m_jobs;
+            m_jobs.clear();
+        }
+
+        if (write(jobs))
+            emit written(jobs.size());
+        else
+            emit failed(jobs.size());
+    }
+
+    Utils::releaseConnections();
+    qDebug() << "DB worker stopped";
+}
+
+bool DbWorker::write(const QList<DbJob>& jobs)
+{
+    QSqlDatabase connection = Utils::database();
+    if (!connection.transaction()) {
+        qCritical() << "Cannot start the transaction of the DB worker";
+        return false;
+    }
+
+    foreach(const DbJob& job, jobs) {
+        if (!job.run()) {
+            connection.rollback();
+            return false;
+        }
+    }
+
+    if (!connection.commit()) {
+        qCritical() << "Cannot commit the transaction of the DB worker";
+        connection.rollback();
+        return false;
+    }
+
+    return true;
+}
+
+} // namespace Data
+} // namespace BSM
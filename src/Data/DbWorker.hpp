@@ -0,0 +1,168 @@
+/*!
+ * \file DbWorker.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the DbJob and DbWorker classes
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef DBWORKER_HPP
+#define DBWORKER_HPP
+
+#include <QtCore/QThread>
+#include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
+#include <QtCore/QList>
+#include <QtCore/QPair>
+#include <QtCore/QString>
+#include <QtCore/QVariant>
+
+namespace BSM {
+namespace Data {
+
+/*!
+ * \class BSM::Data::DbJob
+ * \brief A write to the DB, executed by the DbWorker.
+ *
+ * A job is a SQL statement with the values to bind: the values are copied
+ * when the job is created, so it does not refer to the objects that queued
+ * it and they can change or be deleted while the write is pending.
+ */
+class DbJob
+{
+public:
+    /*! Constructor of the class.
+     * \param name the name of the job, for the logs (e.g. the method that queued it)
+     * \param sql the SQL statement
+     * \param batch \c true to execute the statement once for each value of the bound lists
+     */
+    DbJob(const QString& name, const QString& sql, const bool batch = false);
+
+    /*! Bind a value to a placeholder of the statement.
+     * \param placeholder the placeholder, like \c ":id"
+     * \param value the value, a QVariantList for a batch job
+     */
+    void bindValue(const QString& placeholder, const QVariant& value);
+
+    /*! Execute the job on the connection of the current thread.
+     * \return \c true on success or \c false on failure
+     */
+    bool run() const;
+
+private:
+    QString m_name;
+    QString m_sql;
+    bool    m_batch;
+    QList< QPair<QString, QVariant> > m_values;
+};
+
+/*!
+ * \class BSM::Data::DbWorker
+ * \brief Thread that writes the DB, out of the GUI thread.
+ *
+ * The writes are queued with submit() and executed by the thread on its own
+ * connection, so a wait for the disk or for a lock does not freeze the
+ * windows. All the jobs found in the queue are written in a single
+ * transaction; the jobs submitted between beginBatch() and endBatch() are
+ * always in the same transaction.
+ *
+ * The result of each transaction is reported by the written and failed
+ * signals, queued to the thread of the receivers.
+ *
+ * When no worker is running the jobs are executed at once on the connection
+ * of the calling thread.
+ */
+class DbWorker : public QThread
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(DbWorker)
+
+public:
+    /*! Constructor of the class.
+     *
+     * Only one worker can exist: it is the one used by submit().
+     * \param parent the parent QObject
+     */
+    explicit DbWorker(QObject* parent = 0);
+
+    /*! Destructor of the class.
+     *
+     * The pending jobs are written before the thread is stopped.
+     */
+    virtual ~DbWorker();
+
+    //! Get the worker, \c 0 if none.
+    static DbWorker* getInstance();
+
+    /*! Queue a job for the worker.
+     * \param job the job
+     * \return \c true if the job was queued or, when no worker is running, executed
+     */
+    static bool submit(const DbJob& job);
+
+    /*! Start a batch of jobs, to write in the same transaction.
+     *
+     * Batches can be nested: the jobs are written at the last endBatch().
+     * \return \c true on success or \c false on failure
+     */
+    static bool beginBatch();
+
+    /*! End a batch of jobs.
+     * \return \c true on success or \c false on failure
+     * \sa beginBatch
+     */
+    static bool endBatch();
+
+    //! Write the pending jobs and exit the thread.
+    void stop();
+
+signals:
+    /*! Some jobs were written.
+     * \param jobs the number of jobs in the transaction
+     */
+    void written(const int jobs);
+
+    /*! Some jobs cannot be written, the transaction was rolled back.
+     * \param jobs the number of jobs in the transaction
+     */
+    void failed(const int jobs);
+
+protected:
+    //! The starting point for the thread.
+    virtual void run();
+
+private:
+    static DbWorker* instance;
+
+    QMutex          m_mutex;
+    QWaitCondition  m_condition;
+    QList<DbJob>    m_jobs;
+    int             m_batchDepth;
+    bool            m_stop;
+
+    /*! Write some jobs in a transaction.
+     * \param jobs the jobs
+     * \return \c true on success or \c false on failure
+     */
+    bool write(const QList<DbJob>& jobs);
+};
+
+} // namespace Data
+} // namespace BSM
+
+#endif // DBWORKER_HPP
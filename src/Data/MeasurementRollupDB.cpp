@@ -0,0 +1,297 @@
+/*!
+ * \file MeasurementRollupDB.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the MeasurementRollupDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MeasurementRollupDB.hpp"
+#include "UserMeasurementDB.hpp"
+#include "SchemaMigrator.hpp"
+#include "DbWorker.hpp"
+
+#include <utils.hpp>
+
+#include <QtCore/QDebug>
+#include <QtCore/QSet>
+#include <QtCore/QVariant>
+#include <QtSql/QSqlQuery>
+
+//! Columns of a rollup, decoded by index
+#define ROLLUP_COLUMNS      "bucket, samples, weightSum, weightMin, weightMax, bodyFatSum, bodyFatMin, bodyFatMax, waterSum, waterMin, waterMax, muscleSum, muscleMin, muscleMax"
+//! Aggregates of the measurements, in the order of ROLLUP_COLUMNS after the bucket
+#define ROLLUP_AGGREGATES   "COUNT(*), SUM(weight), MIN(weight), MAX(weight), SUM(bodyFat), MIN(bodyFat), MAX(bodyFat), SUM(water), MIN(water), MAX(water), SUM(muscle), MIN(muscle), MAX(muscle)"
+//! Minutes in a day
+#define MINUTES_PER_DAY     1440
+
+namespace BSM {
+namespace Data {
+
+const QString MeasurementRollupDB::tableName = "MeasurementRollup";
+const uint MeasurementRollupDB::tableVersion = 1;
+
+/*! Get the saved resolution used for a resolution.
+ * \param resolution the requested resolution
+ * \return the coarsest saved resolution that divides \p resolution
+ */
+static MeasurementRollupDB::Resolution savedResolution(const MeasurementRollupDB::Resolution resolution)
+{
+    return resolution < MeasurementRollupDB::Month ? resolution : MeasurementRollupDB::Month;
+}
+
+/*! Get the SQL expression of the start of the period of a timestamp.
+ *
+ * It must give the same result of MeasurementRollupDB::bucketOf().
+ * \param resolution the saved resolution
+ * \param minutes the SQL expression of the timestamp, in minutes since the epoch
+ * \return the SQL expression of the start of the period, in minutes since the epoch
+ */
+static QString bucketExpression(const MeasurementRollupDB::Resolution resolution, const QString& minutes)
+{
+    QString modifiers;
+    switch (resolution) {
+        case MeasurementRollupDB::Day:
+            modifiers = "'start of day'";
+            break;
+        case MeasurementRollupDB::Week:
+            modifiers = "'start of day', '-6 days', 'weekday 1'";
+            break;
+        default:
+            modifiers = "'start of month'";
+            break;
+    }
+    return "(CAST(strftime('%s', " + minutes + " * 60, 'unixepoch', " + modifiers + ") AS INTEGER) / 60)";
+}
+
+/*! Get the SQL that computes the rollups again from the measurements.
+ * \param resolution the saved resolution
+ * \param all \c true for all the measurements, \c false for the ones of \c :userId in the period from \c :from to \c :to
+ * \return the SQL statement
+ */
+static QString rebuildSql(const MeasurementRollupDB::Resolution resolution, const bool all)
+{
+    QString bucket = bucketExpression(resolution, "timestamp");
+    return "INSERT OR REPLACE INTO " + MeasurementRollupDB::tableName + " (userId, resolution, " ROLLUP_COLUMNS ")"
+           " SELECT userId, " + QString::number(resolution) + ", " + bucket + " AS rollupBucket, " ROLLUP_AGGREGATES
+           " FROM " + UserMeasurementDB::tableName +
+           (all ? QString() : QString(" WHERE userId = :userId AND timestamp >= :from AND timestamp < :to")) +
+           " GROUP BY userId, rollupBucket;";
+}
+
+/*! Divide rounding towards minus infinity.
+ * \param value the dividend
+ * \param divisor the divisor, positive
+ * \return the quotient
+ */
+static inline qint64 floorDiv(const qint64 value, const qint64 divisor)
+{
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+/*! Get the start of the period after a period.
+ * \param resolution the saved resolution
+ * \param bucket the start of the period
+ * \return the start of the next period
+ */
+static Timestamp nextBucket(const MeasurementRollupDB::Resolution resolution, const Timestamp& bucket)
+{
+    switch (resolution) {
+        case MeasurementRollupDB::Day:
+            return Timestamp(bucket.toMinutes() + MINUTES_PER_DAY);
+        case MeasurementRollupDB::Week:
+            return Timestamp(bucket.toMinutes() + 7 * MINUTES_PER_DAY);
+        default:
+            // No month is longer than 31 days
+            return MeasurementRollupDB::bucketOf(resolution, Timestamp(bucket.toMinutes() + 31 * MINUTES_PER_DAY));
+    }
+}
+
+/*! Add a rollup to another one of a longer period.
+ * \param total the rollup of the longer period
+ * \param rollup the rollup to add
+ */
+static void addRollup(MeasurementRollup& total, const MeasurementRollup& rollup)
+{
+    MetricRollup MeasurementRollup::* const metrics[] = {
+        &MeasurementRollup::weight, &MeasurementRollup::bodyFat, &MeasurementRollup::water, &MeasurementRollup::muscle
+    };
+
+    total.count += rollup.count;
+    for (unsigned int i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i) {
+        MetricRollup& t = total.*metrics[i];
+        const MetricRollup& r = rollup.*metrics[i];
+        t.sum += r.sum;
+        t.min = qMin(t.min, r.min);
+        t.max = qMax(t.max, r.max);
+    }
+}
+
+/*! Decode a value of a rollup.
+ * \param query the query, with the columns of ROLLUP_COLUMNS
+ * \param first the index of the sum of the value
+ * \return the value
+ */
+static inline MetricRollup decodeMetric(const QSqlQuery& query, const int first)
+{
+    MetricRollup metric;
+    metric.sum = query.value(first).toLongLong();
+    metric.min = query.value(first + 1).toInt();
+    metric.max = query.value(first + 2).toInt();
+    return metric;
+}
+
+bool MeasurementRollupDB::createTable(SchemaMigrator& migrator)
+{
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("userId", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("resolution", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("bucket", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("samples", "INTEGER NOT NULL"));
+    const char* metrics[] = { "weight", "bodyFat", "water", "muscle" };
+    for (unsigned int i = 0; i < sizeof(metrics) / sizeof(metrics[0]); ++i) {
+        columns.append(Utils::Column(QString(metrics[i]) + "Sum", "INTEGER NOT NULL"));
+        columns.append(Utils::Column(QString(metrics[i]) + "Min", "INTEGER NOT NULL"));
+        columns.append(Utils::Column(QString(metrics[i]) + "Max", "INTEGER NOT NULL"));
+    }
+    columns.append(Utils::Column("PRIMARY KEY", "(userId, resolution, bucket)"));
+
+    bool created = !Utils::isTablePresent(tableName);
+    if (!migrator.migrate(tableName, columns, tableVersion, SchemaMigrator::StepList()))
+        return false;
+    if (!created)
+        return true;
+
+    // Fill the new table with the measurements already saved
+    qDebug() << "Computing the rollups of the measurements";
+    QSqlDatabase connection = Utils::database();
+    if (!connection.transaction()) {
+        qCritical() << "Cannot start the transaction for MeasurementRollupDB::createTable()";
+        return false;
+    }
+    for (int resolution = Day; resolution <= Month; ++resolution) {
+        if (!Utils::executeQuery(rebuildSql(Resolution(resolution), true))) {
+            qCritical() << "Cannot compute the rollups for resolution" << resolution;
+            connection.rollback();
+            return false;
+        }
+    }
+    if (!connection.commit()) {
+        qCritical() << "Cannot commit the transaction for MeasurementRollupDB::createTable()";
+        return false;
+    }
+
+    return true;
+}
+
+bool MeasurementRollupDB::update(const uint userId, const UserMeasurementList& measurements)
+{
+    if (measurements.isEmpty())
+        return true;
+
+    for (int resolution = Day; resolution <= Month; ++resolution) {
+        // Only the periods of the new measurements are changed, each one is computed again
+        QSet<qint64> buckets;
+        foreach(const UserMeasurement* m, measurements)
+            buckets.insert(bucketOf(Resolution(resolution), m->getTimestamp()).toMinutes());
+
+        QVariantList userIds, from, to;
+        foreach(const qint64 bucket, buckets) {
+            userIds.append(userId);
+            from.append(bucket);
+            to.append(nextBucket(Resolution(resolution), Timestamp(bucket)).toMinutes());
+        }
+
+        DbJob job("MeasurementRollupDB::update()", rebuildSql(Resolution(resolution), false), true);
+        job.bindValue(":userId", userIds);
+        job.bindValue(":from", from);
+        job.bindValue(":to", to);
+        if (!DbWorker::submit(job))
+            return false;
+    }
+
+    return true;
+}
+
+bool MeasurementRollupDB::load(const uint userId, const Resolution resolution, const Timestamp& from, const Timestamp& to, MeasurementRollupList& rollups)
+{
+    Resolution saved = savedResolution(resolution);
+
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT " ROLLUP_COLUMNS " FROM " + tableName +
+                       " WHERE userId = :userId AND resolution = :resolution AND bucket >= :from AND bucket < :to ORDER BY bucket;", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for MeasurementRollupDB::load()";
+        return false;
+    }
+    query.bindValue(":userId", userId);
+    query.bindValue(":resolution", saved);
+    query.bindValue(":from", from.isValid() ? bucketOf(resolution, from).toMinutes() : Timestamp::Invalid);
+    query.bindValue(":to", to.isValid() ? to.toMinutes() : Q_INT64_C(0x7FFFFFFFFFFFFFFF));
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for MeasurementRollupDB::load()";
+        return false;
+    }
+
+    // The saved periods are added up in the longer ones, if needed
+    int first = rollups.size();
+    while (query.next()) {
+        MeasurementRollup rollup;
+        rollup.bucket = query.value(0).toLongLong();
+        rollup.count = query.value(1).toInt();
+        rollup.weight = decodeMetric(query, 2);
+        rollup.bodyFat = decodeMetric(query, 5);
+        rollup.water = decodeMetric(query, 8);
+        rollup.muscle = decodeMetric(query, 11);
+
+        if (resolution != saved) {
+            rollup.bucket = bucketOf(resolution, Timestamp(rollup.bucket)).toMinutes();
+            if (rollups.size() > first && rollups.last().bucket == rollup.bucket) {
+                addRollup(rollups.last(), rollup);
+                continue;
+            }
+        }
+        rollups.append(rollup);
+    }
+
+    return true;
+}
+
+Timestamp MeasurementRollupDB::bucketOf(const Resolution resolution, const Timestamp& timestamp)
+{
+    qint64 days = floorDiv(timestamp.toMinutes(), MINUTES_PER_DAY);
+    switch (resolution) {
+        case Day:
+            return Timestamp(days * MINUTES_PER_DAY);
+        case Week:
+            // 1970-01-01 was a Thursday, the weeks start on Monday
+            return Timestamp((days - (days + 3 - floorDiv(days + 3, 7) * 7)) * MINUTES_PER_DAY);
+        default:
+            break;
+    }
+
+    QDate date = timestamp.toDateTime().date();
+    int month = date.month();
+    if (resolution == Quarter)
+        month = (month - 1) / 3 * 3 + 1;
+    else if (resolution == Year)
+        month = 1;
+    return Timestamp::fromDateTime(QDateTime(QDate(date.year(), month, 1)));
+}
+
+} // namespace Data
+} // namespace BSM
@@ -0,0 +1,154 @@
+/*!
+ * \file MeasurementRollupDB.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the MeasurementRollupDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEASUREMENTROLLUPDB_HPP
+#define MEASUREMENTROLLUPDB_HPP
+
+#include <Data/UserMeasurement.hpp>
+
+#include <QtCore/QList>
+#include <QtCore/QString>
+
+namespace BSM {
+namespace Data {
+
+class SchemaMigrator;
+
+/*!
+ * \struct BSM::Data::MetricRollup
+ * \brief Aggregate of a value of the measurements in a period, in tenths.
+ */
+struct MetricRollup
+{
+    qint64  sum;    //!< Sum of the values
+    int     min;    //!< Minimum value
+    int     max;    //!< Maximum value
+};
+
+/*!
+ * \struct BSM::Data::MeasurementRollup
+ * \brief Aggregate of the measurements of a user in a period.
+ */
+struct MeasurementRollup
+{
+    qint64          bucket;     //!< Start of the period, in minutes since the epoch
+    int             count;      //!< Number of measurements
+    MetricRollup    weight;     //!< Weight, in tenths of kg
+    MetricRollup    bodyFat;    //!< Body fat, in tenths of percent
+    MetricRollup    water;      //!< Water, in tenths of percent
+    MetricRollup    muscle;     //!< Muscle, in tenths of percent
+
+    /*! Get the average of a value in the period.
+     * \param metric one of the values of this rollup
+     * \return the average, in kg or in percent
+     */
+    double average(const MetricRollup& metric) const
+    {
+        return count > 0 ? metric.sum * 0.1 / count : 0.0;
+    }
+};
+
+//! List of rollups
+typedef QList<MeasurementRollup> MeasurementRollupList;
+
+/*!
+ * \class BSM::Data::MeasurementRollupDB
+ * \brief Aggregates of the measurements of the users by day, week and month.
+ *
+ * For each user and period the table keeps the number of measurements and
+ * the sum, the minimum and the maximum of each value, so the averages of a
+ * long history are read without reading the measurements.
+ *
+ * The rollups are updated with the measurements, in the same transaction:
+ * only the periods of the new measurements are computed again from the
+ * measurements table. The weeks start on Monday.
+ */
+class MeasurementRollupDB
+{
+public:
+    /*! Resolution of the rollups.
+     *
+     * Only the days, the weeks and the months are saved: the quarters and the
+     * years are added up from the months.
+     */
+    enum Resolution {
+        Day,        //!< Rollups by day
+        Week,       //!< Rollups by week
+        Month,      //!< Rollups by month
+        Quarter,    //!< Rollups by quarter of year
+        Year        //!< Rollups by year
+    };
+
+    /*! Create or update the DB table.
+     *
+     * A new table is filled with the measurements already saved.
+     * \param migrator the migrator of the tables
+     * \return \c true on success or \c false on failure
+     */
+    static bool createTable(SchemaMigrator& migrator);
+
+    //! Name of the DB table.
+    static const QString tableName;
+
+    //! Version of the table
+    static const uint tableVersion;
+
+    /*! Update the rollups of a user with new measurements.
+     *
+     * Only the periods that contain the new measurements are computed again.
+     * The writes are queued to the DbWorker: they must follow the insert of
+     * the measurements, in the same batch.
+     * \param userId the ID of the user
+     * \param measurements the new measurements
+     * \return \c true if the writes were queued or \c false on failure
+     * \sa UserMeasurementDB::insert
+     */
+    static bool update(const uint userId, const UserMeasurementList& measurements);
+
+    /*! Load the rollups of a user in a range of time, from the oldest one.
+     *
+     * The rollups are read from the coarsest saved resolution that divides
+     * \p resolution, and added up if it is coarser.
+     * \param userId the ID of the user
+     * \param resolution the resolution of the rollups
+     * \param from the first timestamp of the range, invalid for no lower limit
+     * \param to the timestamp after the range, invalid for no upper limit
+     * \param rollups the list where the rollups are appended
+     * \return \c true on success or \c false on failure
+     */
+    static bool load(const uint userId, const Resolution resolution, const Timestamp& from, const Timestamp& to, MeasurementRollupList& rollups);
+
+    /*! Get the start of the period that contains a timestamp.
+     * \param resolution the resolution of the period
+     * \param timestamp the timestamp, valid
+     * \return the start of the period
+     */
+    static Timestamp bucketOf(const Resolution resolution, const Timestamp& timestamp);
+};
+
+} // namespace Data
+} // namespace BSM
+
+Q_DECLARE_TYPEINFO(BSM::Data::MeasurementRollup, Q_PRIMITIVE_TYPE);
+
+#endif // MEASUREMENTROLLUPDB_HPP
@@ -0,0 +1,181 @@
+/*!
+ * \file MeasurementRollupModel.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the MeasurementRollupModel class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MeasurementRollupModel.hpp"
+
+#include <QtGui/QApplication>
+#include <QtGui/QPalette>
+
+namespace BSM {
+namespace Data {
+namespace Models {
+
+MeasurementRollupModel::MeasurementRollupModel(const uint userId, const MeasurementRollupDB::Resolution resolution, const Timestamp& from, const Timestamp& to, QObject* parent)
+    : QAbstractItemModel(parent)
+    , m_resolution(resolution)
+{
+    // The rollups are loaded from the oldest period, they are shown from the newest one
+    MeasurementRollupList rollups;
+    if (!MeasurementRollupDB::load(userId, resolution, from, to, rollups))
+        return;
+    m_list.reserve(rollups.size());
+    for (int i = rollups.size() - 1; i >= 0; --i)
+        m_list.append(rollups.at(i));
+}
+
+MeasurementRollupModel::~MeasurementRollupModel()
+{}
+
+QVariant MeasurementRollupModel::data(const QModelIndex& index, int role) const
+{
+    if (!index.isValid())
+        return QVariant();
+
+    const MeasurementRollup& rollup = m_list.at(index.row());
+
+    QLocale locale;
+    if (role == Qt::DisplayRole) {
+        switch (index.column()) {
+            case 0: // Period
+                return periodName(rollup);
+            case 1: // Measurements
+                return locale.toString(rollup.count);
+            case 2: // Weight
+                return locale.toString(rollup.average(rollup.weight), 'f', 1);
+            case 3: // Body fat
+                return locale.toString(rollup.average(rollup.bodyFat), 'f', 1);
+            case 4: // Water
+                return locale.toString(rollup.average(rollup.water), 'f', 1);
+            case 5: // Muscle
+                return locale.toString(rollup.average(rollup.muscle), 'f', 1);
+        }
+    }
+    else if (role == Qt::ToolTipRole) {
+        const MetricRollup* metric = 0;
+        switch (index.column()) {
+            case 2: // Weight
+                metric = &rollup.weight;
+                break;
+            case 3: // Body fat
+                metric = &rollup.bodyFat;
+                break;
+            case 4: // Water
+                metric = &rollup.water;
+                break;
+            case 5: // Muscle
+                metric = &rollup.muscle;
+                break;
+        }
+        if (metric)
+            return tr("From %1 to %2").arg(locale.toString(metric->min * 0.1, 'f', 1)).arg(locale.toString(metric->max * 0.1, 'f', 1));
+    }
+    else if (role == Qt::TextAlignmentRole) {
+        switch (index.column()) {
+            case 0: // Period
+                return Qt::AlignHCenter + Qt::AlignVCenter;
+            case 1: // Measurements
+            case 2: // Weight
+            case 3: // Body fat
+            case 4: // Water
+            case 5: // Muscle
+                return Qt::AlignRight + Qt::AlignVCenter;
+        }
+    }
+    else if (role == Qt::BackgroundRole) {
+        return QApplication::palette().color((index.row() % 2 == 0) ? QPalette::Base : QPalette::AlternateBase);
+    }
+
+    return QVariant();
+}
+
+int MeasurementRollupModel::columnCount(const QModelIndex& parent) const
+{
+    return 6;
+}
+
+int MeasurementRollupModel::rowCount(const QModelIndex& parent) const
+{
+    return m_list.size();
+}
+
+QModelIndex MeasurementRollupModel::parent(const QModelIndex& child) const
+{
+    return QModelIndex();
+}
+
+QModelIndex MeasurementRollupModel::index(int row, int column, const QModelIndex& parent) const
+{
+    if (!hasIndex(row, column, parent))
+        return QModelIndex();
+
+    return createIndex(row, column);
+}
+
+QVariant MeasurementRollupModel::headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation == Qt::Horizontal && role == Qt::DisplayRole) {
+        switch (section) {
+            case 0:
+                return tr("Period");
+            case 1:
+                return tr("Measurements");
+            case 2:
+                return tr("Weight");
+            case 3:
+                return tr("% Body fat");
+            case 4:
+                return tr("% Water");
+            case 5:
+                return tr("% Muscle");
+        }
+    }
+
+    return QVariant();
+}
+
+const MeasurementRollup& MeasurementRollupModel::getRollup(const int row) const
+{
+    return m_list.at(row);
+}
+
+QString MeasurementRollupModel::periodName(const MeasurementRollup& rollup) const
+{
+    QDate date = Timestamp(rollup.bucket).toDateTime().date();
+    switch (m_resolution) {
+        case MeasurementRollupDB::Day:
+            return date.toString(Qt::SystemLocaleLongDate);
+        case MeasurementRollupDB::Week:
+            return tr("Week of %1").arg(date.toString(Qt::SystemLocaleShortDate));
+        case MeasurementRollupDB::Month:
+            return QLocale().standaloneMonthName(date.month()) + " " + QString::number(date.year());
+        case MeasurementRollupDB::Quarter:
+            return tr("Q%1 %2").arg((date.month() - 1) / 3 + 1).arg(date.year());
+        case MeasurementRollupDB::Year:
+            return QString::number(date.year());
+    }
+    return QString();
+}
+
+} // namespace Models
+} // namespace Data
+} // namespace BSM
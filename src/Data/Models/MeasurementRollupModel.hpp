@@ -0,0 +1,91 @@
+/*!
+ * \file MeasurementRollupModel.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the MeasurementRollupModel class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef MEASUREMENTROLLUPMODEL_HPP
+#define MEASUREMENTROLLUPMODEL_HPP
+
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QVariant>
+#include <QtCore/QModelIndex>
+
+#include <Data/MeasurementRollupDB.hpp>
+
+namespace BSM {
+namespace Data {
+namespace Models {
+
+/*!
+ * \class BSM::Data::Models::MeasurementRollupModel
+ * \brief Model for the rollups of the measurements
+ *
+ * This class is the model to show the averages of the measurements of a user
+ * by period in a table-view, from the newest period. The rollups are read
+ * from MeasurementRollupDB at once: a long history has few periods.
+ */
+class MeasurementRollupModel : public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+    /*! Constructor of the class.
+     * \param userId the ID of the user whose measurements are represented
+     * \param resolution the length of the periods
+     * \param from the first timestamp of the range, invalid for no lower limit
+     * \param to the timestamp after the range, invalid for no upper limit
+     * \param parent the parent QObject
+     */
+    MeasurementRollupModel(const uint userId, const MeasurementRollupDB::Resolution resolution, const Timestamp& from, const Timestamp& to, QObject* parent = 0);
+    virtual ~MeasurementRollupModel();
+
+    //! Returns the data stored under the given \p role for the item referred to by the \p index.
+    virtual QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+    //! Returns the number of columns for the children of the given \p parent.
+    virtual int columnCount(const QModelIndex& parent = QModelIndex()) const;
+    //! Returns the number of rows under the given \p parent.
+    virtual int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    //! Returns the parent of the model item with the given \p index. This model is flat, so an invalid QModelIndex is always returned.
+    virtual QModelIndex parent(const QModelIndex& child) const;
+    //! Returns the index of the item in the model specified by the given \p row, \p column and \p parent index.
+    virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
+    //! Returns the data for the given \p role and \p section in the header with the specified \p orientation.
+    virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+
+    /*! Get the rollup of a row.
+     * \param row the row
+     * \return the rollup of the period
+     */
+    const MeasurementRollup& getRollup(const int row) const;
+
+private:
+    //! Get the name of the period of a rollup.
+    QString periodName(const MeasurementRollup& rollup) const;
+
+    const MeasurementRollupDB::Resolution   m_resolution;
+    MeasurementRollupList                   m_list;     // The rollups, from the newest one
+};
+
+} // namespace Models
+} // namespace Data
+} // namespace BSM
+
+#endif // MEASUREMENTROLLUPMODEL_HPP
@@ -45,8 +45,12 @@ QVariant UserDataModel::data(const QModelIndex& index, int role) const
     if (!userData)
         return QVariant();
 
-    if (role == Qt::DisplayRole)
+    if (role == Qt::DisplayRole) {
+        int added = m_newMeasurements.value(userData->getId());
+        if (added > 0)
+            return userData->getName() + " (" + tr("%n new", 0, added) + ")";
         return userData->getName();
+    }
 
     return QVariant();
 }
@@ -66,6 +70,20 @@ QModelIndex UserDataModel::parent(const QModelIndex& child) const
     return QModelIndex();
 }
 
+void UserDataModel::userParsed(BSM::Data::UserData* user)
+{
+    for (int row = 0; row < m_list.size(); ++row) {
+        UserDataDB* userData = m_list.at(row);
+        if (!userData || userData->getId() != user->getId())
+            continue;
+
+        UserMeasurementRange range = userData->getNewMeasurements(*user);
+        m_newMeasurements.insert(user->getId(), range.second - range.first);
+        emit dataChanged(index(row, 0), index(row, 0));
+        return;
+    }
+}
+
 QModelIndex UserDataModel::index(int row, int column, const QModelIndex& parent) const
 {
     if (!hasIndex(row, column, parent))
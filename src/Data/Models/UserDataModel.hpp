@@ -27,6 +27,7 @@
 #include <QtCore/QAbstractItemModel>
 #include <QtCore/QVariant>
 #include <QtCore/QModelIndex>
+#include <QtCore/QHash>
 
 #include <Data/UserDataDB.hpp>
 
@@ -39,6 +40,8 @@ namespace Models {
  * \brief Model for the UserData objects
  *
  * This class is the model to insert a UserDataList in a list-view, like a QComboBox.
+ * While a download is in progress, the users parsed from the scale show the
+ * number of their new measurements.
  */
 class UserDataModel : public QAbstractItemModel
 {
@@ -63,8 +66,16 @@ public:
     //! Returns the index of the item in the model specified by the given \p row, \p column and \p parent index.
     virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
 
+public slots:
+    /*! A user was parsed from the scale: show the number of its new measurements.
+     * \param user the user parsed
+     * \sa Usb::UsbData::userParsed
+     */
+    void userParsed(BSM::Data::UserData* user);
+
 private:
     const UserDataDBList  m_list;
+    QHash<int, int>       m_newMeasurements;
 };
 
 } // namespace Models
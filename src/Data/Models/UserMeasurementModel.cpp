@@ -23,17 +23,40 @@
 
 #include "UserMeasurementModel.hpp"
 
+#include <Data/UserMeasurementDB.hpp>
+
 #include <QtGui/QApplication>
 #include <QtGui/QPalette>
 
+//! Number of measurements loaded from the DB at each fetch
+#define MEASUREMENT_PAGE_SIZE   256
+
 namespace BSM {
 namespace Data {
 namespace Models {
 
-UserMeasurementModel::UserMeasurementModel(const UserMeasurementList& list, QObject* parent)
+UserMeasurementModel::UserMeasurementModel(const uint userId, QObject* parent)
     : QAbstractItemModel(parent)
-    , m_list(list)
-{}
+    , m_userId(userId)
+    , m_atEnd(false)
+{
+    // The first page, so the newest measurement can be selected at once
+    fetchMore(QModelIndex());
+}
+
+UserMeasurementModel::UserMeasurementModel(const uint userId, const Timestamp& from, const Timestamp& to, QObject* parent)
+    : QAbstractItemModel(parent)
+    , m_userId(userId)
+    , m_atEnd(true)
+{
+    // The range is loaded from the oldest measurement, it is shown from the newest one
+    UserMeasurementList range;
+    if (UserMeasurementDB::loadRange(m_userId, from, to, range, this) <= 0)
+        return;
+    m_list.reserve(range.size());
+    for (int i = range.size() - 1; i >= 0; --i)
+        m_list.append(range.at(i));
+}
 
 UserMeasurementModel::~UserMeasurementModel()
 {}
@@ -132,6 +155,31 @@ QVariant UserMeasurementModel::headerData(int section, Qt::Orientation orientati
     return QVariant();
 }
 
+bool UserMeasurementModel::canFetchMore(const QModelIndex& parent) const
+{
+    if (parent.isValid())
+        return false;
+    return !m_atEnd;
+}
+
+void UserMeasurementModel::fetchMore(const QModelIndex& parent)
+{
+    if (parent.isValid() || m_atEnd)
+        return;
+
+    Timestamp before = m_list.isEmpty() ? Timestamp() : m_list.last()->getTimestamp();
+    UserMeasurementList page;
+    int loaded = UserMeasurementDB::loadPage(m_userId, before, MEASUREMENT_PAGE_SIZE, page, this);
+    if (loaded < MEASUREMENT_PAGE_SIZE)
+        m_atEnd = true;
+    if (loaded <= 0)
+        return;
+
+    beginInsertRows(QModelIndex(), m_list.size(), m_list.size() + loaded - 1);
+    m_list.append(page);
+    endInsertRows();
+}
+
 } // namespace Models
 } // namespace Data
 } // namespace BSM
@@ -38,7 +38,13 @@ namespace Models {
  * \class BSM::Data::Models::UserMeasurementModel
  * \brief Model for the UserMeasurement objects
  *
- * This class is the model to insert a UserMeasurementList in a list-view, like a QComboBox.
+ * This class is the model to show the measurements of a user in a table-view, from the
+ * newest one.
+ *
+ * The measurements are loaded from the DB in pages, when the view asks for
+ * them with canFetchMore() and fetchMore(): only the rows scrolled so far are
+ * kept in memory. The measurements of a range of time are loaded at once,
+ * with a range scan of the key.
  */
 class UserMeasurementModel : public QAbstractItemModel
 {
@@ -46,10 +52,17 @@ class UserMeasurementModel : public QAbstractItemModel
 
 public:
     /*! Constructor of the class.
-     * \param list the UserMeasurementList to represents
+     * \param userId the ID of the user whose measurements are represented
+     * \param parent the parent QObject
+     */
+    UserMeasurementModel(const uint userId, QObject* parent = 0);
+    /*! Constructor of the class, for a range of time.
+     * \param userId the ID of the user whose measurements are represented
+     * \param from the first timestamp of the range, invalid for no lower limit
+     * \param to the timestamp after the range, invalid for no upper limit
      * \param parent the parent QObject
      */
-    UserMeasurementModel(const UserMeasurementList& list, QObject* parent = 0);
+    UserMeasurementModel(const uint userId, const Timestamp& from, const Timestamp& to, QObject* parent = 0);
     virtual ~UserMeasurementModel();
 
     //! Returns the data stored under the given \p role for the item referred to by the \p index.
@@ -64,9 +77,15 @@ public:
     virtual QModelIndex index(int row, int column, const QModelIndex& parent = QModelIndex()) const;
     //! Returns the data for the given \p role and \p section in the header with the specified \p orientation. For horizontal headers, the section number corresponds to the column number. Similarly, for vertical headers, the section number corresponds to the row number.
     virtual QVariant headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const;
+    //! Returns \c true if there are older measurements to load from the DB.
+    virtual bool canFetchMore(const QModelIndex& parent) const;
+    //! Loads the next page of older measurements from the DB.
+    virtual void fetchMore(const QModelIndex& parent);
 
 private:
-    const UserMeasurementList  m_list;
+    const uint          m_userId;
+    UserMeasurementList m_list;     // The measurements loaded so far, owned by the model
+    bool                m_atEnd;    // All the measurements were loaded
 };
 
 } // namespace Models
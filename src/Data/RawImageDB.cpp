@@ -0,0 +1,161 @@
+/*!
+ * \file RawImageDB.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the RawImageDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "RawImageDB.hpp"
+#include "SchemaMigrator.hpp"
+#include "DbWorker.hpp"
+
+#include <utils.hpp>
+
+#include <QtCore/QDebug>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QVariant>
+#include <QtSql/QSqlQuery>
+
+//! Number of hashes kept in memory for each scale
+#define RAW_IMAGE_RECENT    8
+
+namespace BSM {
+namespace Data {
+
+const QString RawImageDB::tableName = "RawImages";
+const uint RawImageDB::tableVersion = 1;
+
+//! Hashes of the last images by scale, the newest first
+static QHash<QString, QList<quint64> > recentHashes;
+
+/*! Get the hashes of the last images of a scale, loaded from the DB at the first use.
+ * \param device the identifier of the scale
+ * \return the hashes, the newest first
+ */
+static QList<quint64>& recentHashesOf(const QString& device)
+{
+    QHash<QString, QList<quint64> >::iterator it = recentHashes.find(device);
+    if (it != recentHashes.end())
+        return *it;
+
+    QList<quint64>& hashes = recentHashes[device];
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT hash FROM " + RawImageDB::tableName + " WHERE device = :device ORDER BY downloaded DESC LIMIT " + QString::number(RAW_IMAGE_RECENT) + ";", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for RawImageDB::isRecent()";
+        return hashes;
+    }
+    query.bindValue(":device", device);
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for RawImageDB::isRecent()";
+        return hashes;
+    }
+    while (query.next())
+        hashes.append((quint64) query.value(0).toLongLong());
+
+    return hashes;
+}
+
+bool RawImageDB::createTable(SchemaMigrator& migrator)
+{
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("device", "TEXT NOT NULL"));
+    columns.append(Utils::Column("hash", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("downloaded", "TEXT NOT NULL"));
+    columns.append(Utils::Column("size", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("image", "BLOB NOT NULL"));
+    columns.append(Utils::Column("PRIMARY KEY", "(device, hash)"));
+
+    return migrator.migrate(tableName, columns, tableVersion, SchemaMigrator::StepList());
+}
+
+bool RawImageDB::isRecent(const QString& device, const quint64 hash)
+{
+    return recentHashesOf(device).contains(hash);
+}
+
+void RawImageDB::clearRecent()
+{
+    recentHashes.clear();
+}
+
+bool RawImageDB::archive(const QString& device, const quint64 hash, const QDateTime& downloaded, const QByteArray& image)
+{
+    QList<quint64>& hashes = recentHashesOf(device);
+
+    DbJob job("RawImageDB::archive()", "INSERT OR REPLACE INTO " + tableName + " (device, hash, downloaded, size, image) VALUES (:device, :hash, :downloaded, :size, :image);");
+    job.bindValue(":device", device);
+    job.bindValue(":hash", (qint64) hash);
+    job.bindValue(":downloaded", downloaded);
+    job.bindValue(":size", image.size());
+    job.bindValue(":image", qCompress(image));
+    if (!DbWorker::submit(job))
+        return false;
+
+    hashes.removeAll(hash);
+    hashes.prepend(hash);
+    while (hashes.size() > RAW_IMAGE_RECENT)
+        hashes.removeLast();
+
+    return true;
+}
+
+QByteArray RawImageDB::load(const QString& device, const quint64 hash)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT image FROM " + tableName + " WHERE device = :device AND hash = :hash;", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for RawImageDB::load()";
+        return QByteArray();
+    }
+    query.bindValue(":device", device);
+    query.bindValue(":hash", (qint64) hash);
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for RawImageDB::load()";
+        return QByteArray();
+    }
+    if (!query.next())
+        return QByteArray();
+
+    QByteArray image = query.value(0).toByteArray();
+    query.finish();
+    return qUncompress(image);
+}
+
+QByteArray RawImageDB::loadLast(const QString& device)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT image FROM " + tableName + " WHERE device = :device ORDER BY downloaded DESC LIMIT 1;", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for RawImageDB::loadLast()";
+        return QByteArray();
+    }
+    query.bindValue(":device", device);
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for RawImageDB::loadLast()";
+        return QByteArray();
+    }
+    if (!query.next())
+        return QByteArray();
+
+    QByteArray image = query.value(0).toByteArray();
+    query.finish();
+    return qUncompress(image);
+}
+
+} // namespace Data
+} // namespace BSM
@@ -0,0 +1,105 @@
+/*!
+ * \file RawImageDB.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the RawImageDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef RAWIMAGEDB_HPP
+#define RAWIMAGEDB_HPP
+
+#include <QtCore/QString>
+#include <QtCore/QByteArray>
+#include <QtCore/QDateTime>
+
+namespace BSM {
+namespace Data {
+
+class SchemaMigrator;
+
+/*!
+ * \class BSM::Data::RawImageDB
+ * \brief Archive of the memory images downloaded from the scales.
+ *
+ * Each image is identified by the scale it was downloaded from and by the
+ * hash of its content (see Usb::UsbData::imageHash()). Only the images that
+ * changed are saved, compressed, so a download can be replayed when the
+ * decoded data look wrong.
+ *
+ * The hashes of the last images of each scale are kept in memory: a download
+ * with the same content of a recent one has nothing new to parse or merge.
+ */
+class RawImageDB
+{
+public:
+    /*! Create or update the DB table.
+     * \param migrator the migrator of the tables
+     * \return \c true on success or \c false on failure
+     */
+    static bool createTable(SchemaMigrator& migrator);
+
+    //! Name of the DB table.
+    static const QString tableName;
+
+    //! Version of the table
+    static const uint tableVersion;
+
+    /*! Check if an image was recently downloaded from a scale.
+     * \param device the identifier of the scale
+     * \param hash the hash of the content of the image
+     * \return \c true if the image is one of the last ones of the scale
+     */
+    static bool isRecent(const QString& device, const quint64 hash);
+
+    /*! Forget the recent images of all the scales.
+     *
+     * They are read again from the DB at the next use, e.g. when an archive()
+     * queued to the DbWorker was not written.
+     */
+    static void clearRecent();
+
+    /*! Save an image on the DB.
+     *
+     * The write is queued to the DbWorker.
+     * \param device the identifier of the scale
+     * \param hash the hash of the content of the image
+     * \param downloaded the date and time of the download
+     * \param image the memory image of the scale
+     * \return \c true if the write was queued or \c false on failure
+     */
+    static bool archive(const QString& device, const quint64 hash, const QDateTime& downloaded, const QByteArray& image);
+
+    /*! Load an image from the DB.
+     * \param device the identifier of the scale
+     * \param hash the hash of the content of the image
+     * \return the memory image of the scale, or a \c null QByteArray if not found
+     */
+    static QByteArray load(const QString& device, const quint64 hash);
+
+    /*! Load the last image saved for a scale.
+     * \param device the identifier of the scale
+     * \return the memory image of the scale, or a \c null QByteArray if not found
+     */
+    static QByteArray loadLast(const QString& device);
+};
+
+} // namespace Data
+} // namespace BSM
+
+#endif // RAWIMAGEDB_HPP
@@ -0,0 +1,50 @@
+/*!
+ * \file SampleCursor.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the SampleCursor structure
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SAMPLECURSOR_HPP
+#define SAMPLECURSOR_HPP
+
+#include <QtCore/QtGlobal>
+
+namespace BSM {
+namespace Data {
+
+/*!
+ * \struct BSM::Data::SampleCursor
+ * \brief Position of a user in the ring of the samples of the scale.
+ *
+ * The scale keeps the samples of each user in a ring: the cursor saved at a
+ * download tells which samples are new at the next one, so only those have
+ * to be decoded.
+ */
+struct SampleCursor
+{
+    qint64  timestamp;  //!< Newest sample known, in minutes since the epoch, or Timestamp::Invalid
+    quint8  count;      //!< Number of samples reported by the scale
+    quint8  pointer;    //!< Index of the oldest sample when the ring is full
+};
+
+} // namespace Data
+} // namespace BSM
+
+#endif // SAMPLECURSOR_HPP
@@ -0,0 +1,376 @@
+/*!
+ * \file SchemaMigrator.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the SchemaMigrator class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "SchemaMigrator.hpp"
+
+#include <QtCore/QDebug>
+#include <QtCore/QDataStream>
+#include <QtCore/QVector>
+#include <QtSql/QSqlQuery>
+
+//! Table name for the state of the copies
+#define MIGRATION_TABLE_NAME    "MigrationState"
+//! Default number of rows copied in each savepoint
+#define MIGRATION_BATCH_SIZE    5000
+
+namespace BSM {
+namespace Data {
+
+//! Start the savepoint of a migration.
+static bool beginSavepoint()
+{
+    return Utils::executeQuery("SAVEPOINT migration;");
+}
+
+//! Commit the savepoint of a migration.
+static bool releaseSavepoint()
+{
+    return Utils::executeQuery("RELEASE migration;");
+}
+
+//! Discard the savepoint of a migration, the schema is loaded again.
+static void rollbackSavepoint()
+{
+    if (!Utils::executeQuery("ROLLBACK TO migration;") || !Utils::executeQuery("RELEASE migration;"))
+        qCritical() << "Cannot roll back the migration";
+    Utils::loadSchemaCatalog();
+}
+
+/*! Load the state of an interrupted copy.
+ * \param tableName the name of the table
+ * \param version the version of the copy
+ * \param lastKey the key of the last row copied, empty if none
+ * \param copied the number of rows copied
+ * \return \c true if the copy was found
+ */
+static bool loadState(const QString& tableName, const int version, QVariantList& lastKey, qint64& copied)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT lastKey, copied FROM " MIGRATION_TABLE_NAME " WHERE tableName = :tableName AND version = :version;")) {
+        qCritical() << "Cannot prepare query for the state of the migration";
+        return false;
+    }
+    query.bindValue(":tableName", tableName);
+    query.bindValue(":version", version);
+    if (!query.exec() || !query.next())
+        return false;
+
+    QByteArray key = query.value(0).toByteArray();
+    copied = query.value(1).toLongLong();
+    query.finish();
+
+    QDataStream stream(key);
+    stream >> lastKey;
+    return true;
+}
+
+/*! Save the state of a copy.
+ * \param tableName the name of the table
+ * \param version the version of the copy
+ * \param lastKey the key of the last row copied, empty if none
+ * \param copied the number of rows copied
+ * \return \c true on success or \c false on failure
+ */
+static bool saveState(const QString& tableName, const int version, const QVariantList& lastKey, const qint64 copied)
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+    stream << lastKey;
+
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "INSERT OR REPLACE INTO " MIGRATION_TABLE_NAME " (tableName, version, lastKey, copied) VALUES (:tableName, :version, :lastKey, :copied);")) {
+        qCritical() << "Cannot prepare query for the state of the migration";
+        return false;
+    }
+    query.bindValue(":tableName", tableName);
+    query.bindValue(":version", version);
+    query.bindValue(":lastKey", key);
+    query.bindValue(":copied", copied);
+    return query.exec();
+}
+
+/*! Delete the state of a completed copy.
+ * \param tableName the name of the table
+ * \return \c true on success or \c false on failure
+ */
+static bool clearState(const QString& tableName)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "DELETE FROM " MIGRATION_TABLE_NAME " WHERE tableName = :tableName;"))
+        return false;
+    query.bindValue(":tableName", tableName);
+    return query.exec();
+}
+
+/*! Count the rows of a table.
+ * \param tableName the name of the table
+ * \return the number of rows, \c 0 on failure
+ */
+static qint64 countRows(const QString& tableName)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT COUNT(*) FROM " + tableName + ";") || !query.exec() || !query.next())
+        return 0;
+    qint64 count = query.value(0).toLongLong();
+    query.finish();
+    return count;
+}
+
+SchemaMigrator::Step::Step(const int version, const QStringList& statements)
+    : version(version)
+    , statements(statements)
+{
+}
+
+SchemaMigrator::Step::Step(const int version, const Utils::ColumnList& columns, const QStringList& keyColumns,
+                           const QStringList& select, const QStringList& statements)
+    : version(version)
+    , statements(statements)
+    , columns(columns)
+    , keyColumns(keyColumns)
+    , select(select)
+{
+}
+
+SchemaMigrator::SchemaMigrator(QObject* parent)
+    : QObject(parent)
+    , m_batchSize(MIGRATION_BATCH_SIZE)
+{
+}
+
+SchemaMigrator::~SchemaMigrator()
+{
+}
+
+int SchemaMigrator::getBatchSize() const
+{
+    return m_batchSize;
+}
+
+void SchemaMigrator::setBatchSize(const int batchSize)
+{
+    m_batchSize = qMax(1, batchSize);
+}
+
+bool SchemaMigrator::migrate(const QString& tableName, const Utils::ColumnList& columns, const int tableVersion, const StepList& steps, const bool withoutRowid)
+{
+    int version = Utils::getTableVersion(tableName);
+
+    // Check if table is already present and updated
+    if (version == tableVersion)
+        return true;
+
+    // Create table, with its version
+    if (version == 0) {
+        if (!beginSavepoint())
+            return false;
+        if ((!Utils::isTablePresent(tableName) && !Utils::createTable(tableName, columns, withoutRowid)) ||
+            !Utils::setTableVersion(tableName, tableVersion)
+        ) {
+            rollbackSavepoint();
+            return false;
+        }
+        return releaseSavepoint();
+    }
+
+    // Unknown version: the data are kept, the user has to check them
+    if (version < 0 || version > tableVersion) {
+        qCritical() << "Unknown version" << version << "of table" << tableName;
+        return false;
+    }
+
+    // The state of the copies survives an interruption
+    if (!Utils::isTablePresent(MIGRATION_TABLE_NAME)) {
+        Utils::ColumnList stateColumns;
+        stateColumns.append(Utils::Column("tableName", "TEXT PRIMARY KEY NOT NULL"));
+        stateColumns.append(Utils::Column("version", "INTEGER NOT NULL"));
+        stateColumns.append(Utils::Column("lastKey", "BLOB"));
+        stateColumns.append(Utils::Column("copied", "INTEGER NOT NULL"));
+        if (!Utils::createTable(MIGRATION_TABLE_NAME, stateColumns))
+            return false;
+    }
+
+    // Updates of the table, one version at a time
+    while (version < tableVersion) {
+        const Step* step = 0;
+        foreach(const Step& s, steps) {
+            if (s.version == version + 1) {
+                step = &s;
+                break;
+            }
+        }
+        if (!step) {
+            qCritical() << "Cannot update table" << tableName << "from version" << version;
+            return false;
+        }
+
+        qDebug() << "Updating table" << tableName << "to version" << step->version;
+        emit started(tr("Updating the table %1 to version %2...").arg(tableName).arg(step->version));
+        emit progress(0);
+        if (!runStep(tableName, *step, withoutRowid)) {
+            qCritical() << "Cannot update table" << tableName << "to version" << step->version;
+            return false;
+        }
+        emit progress(100);
+        version = step->version;
+    }
+
+    // The cached queries may refer to the old definitions
+    Utils::clearQueryCache();
+    return true;
+}
+
+bool SchemaMigrator::runStep(const QString& tableName, const Step& step, const bool withoutRowid)
+{
+    if (!step.columns.isEmpty())
+        return copyRows(tableName, step, withoutRowid);
+
+    if (!beginSavepoint())
+        return false;
+    if (!runStatements(step.statements) || !Utils::setTableVersion(tableName, step.version)) {
+        rollbackSavepoint();
+        return false;
+    }
+    return releaseSavepoint();
+}
+
+bool SchemaMigrator::copyRows(const QString& tableName, const Step& step, const bool withoutRowid)
+{
+    const QString copyName = tableName + "_v" + QString::number(step.version);
+
+    // Go on with an interrupted copy or start a new one
+    QVariantList lastKey;
+    qint64 copied = 0;
+    if (loadState(tableName, step.version, lastKey, copied) && Utils::isTablePresent(copyName)) {
+        qDebug() << "Resuming the update of table" << tableName << "after" << copied << "rows";
+    }
+    else {
+        lastKey.clear();
+        copied = 0;
+        if (!beginSavepoint())
+            return false;
+        if (!Utils::dropTable(copyName) ||
+            !Utils::createTable(copyName, step.columns, withoutRowid) ||
+            !saveState(tableName, step.version, lastKey, copied)
+        ) {
+            rollbackSavepoint();
+            return false;
+        }
+        if (!releaseSavepoint())
+            return false;
+    }
+    const qint64 total = countRows(tableName);
+
+    // Queries for the batches, the rows are selected after the last key
+    const int numKeys = step.keyColumns.size();
+    const int numColumns = step.select.size();
+    const QString keys = step.keyColumns.join(", ");
+    QStringList keyParams;
+    for (int i = 0; i < numKeys; ++i)
+        keyParams << ":key" + QString::number(i);
+    const QString select = "SELECT " + keys + ", " + step.select.join(", ") + " FROM " + tableName;
+    const QString limit = " ORDER BY " + keys + " LIMIT " + QString::number(m_batchSize) + ";";
+    const QString firstSql = select + limit;
+    const QString nextSql = select + " WHERE (" + keys + ") > (" + keyParams.join(", ") + ")" + limit;
+
+    QStringList names, params;
+    foreach(const Utils::Column& column, step.columns) {
+        if (column.first.contains(' '))
+            continue; // A constraint of the table
+        names << column.first;
+        params << "?";
+    }
+    const QString insertSql = "INSERT INTO " + copyName + " (" + names.join(", ") + ") VALUES (" + params.join(", ") + ");";
+
+    forever {
+        QSqlQuery query;
+        if (!Utils::prepareQuery(query, lastKey.isEmpty() ? firstSql : nextSql))
+            return false;
+        for (int i = 0; i < lastKey.size(); ++i)
+            query.bindValue(keyParams.at(i), lastKey.at(i));
+        if (!query.exec())
+            return false;
+
+        QVector<QVariantList> values(numColumns);
+        int rows = 0;
+        while (query.next()) {
+            lastKey.clear();
+            for (int i = 0; i < numKeys; ++i)
+                lastKey << query.value(i);
+            for (int column = 0; column < numColumns; ++column)
+                values[column] << query.value(numKeys + column);
+            ++rows;
+        }
+        query.finish();
+        if (rows == 0)
+            break;
+
+        // The batch and the state are committed together
+        QSqlQuery insert;
+        if (!Utils::prepareQuery(insert, insertSql))
+            return false;
+        for (int column = 0; column < numColumns; ++column)
+            insert.bindValue(column, values[column]);
+        if (!beginSavepoint())
+            return false;
+        if (!insert.execBatch() || !saveState(tableName, step.version, lastKey, copied + rows)) {
+            rollbackSavepoint();
+            return false;
+        }
+        if (!releaseSavepoint())
+            return false;
+
+        copied += rows;
+        emit progress(total > 0 ? int(qMin<qint64>(99, 100 * copied / total)) : 99);
+        if (rows < m_batchSize)
+            break;
+    }
+
+    // Replace the old table
+    if (!beginSavepoint())
+        return false;
+    if (!Utils::dropTable(tableName) ||
+        !Utils::renameTable(copyName, tableName) ||
+        !runStatements(step.statements) ||
+        !Utils::setTableVersion(tableName, step.version) ||
+        !clearState(tableName)
+    ) {
+        rollbackSavepoint();
+        return false;
+    }
+    return releaseSavepoint();
+}
+
+bool SchemaMigrator::runStatements(const QStringList& statements)
+{
+    foreach(const QString& sql, statements) {
+        if (!Utils::executeQuery(sql)) {
+            qCritical() << "Cannot execute" << sql;
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace Data
+} // namespace BSM
@@ -0,0 +1,145 @@
+/*!
+ * \file SchemaMigrator.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the SchemaMigrator class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef SCHEMAMIGRATOR_HPP
+#define SCHEMAMIGRATOR_HPP
+
+#include <QtCore/QObject>
+#include <QtCore/QStringList>
+#include <QtCore/QVariant>
+
+#include <utils.hpp>
+
+namespace BSM {
+namespace Data {
+
+/*!
+ * \class BSM::Data::SchemaMigrator
+ * \brief Creation and update of the DB tables, without losing data.
+ *
+ * Each table has its version in the version table of Utils. A table that is
+ * not present is created with its last definition; an older one is updated
+ * by its Step list, one version at a time.
+ *
+ * A step can just execute some statements, like \c ALTER \c TABLE, in a
+ * savepoint together with the update of the version: a step interrupted (even
+ * by a crash) is executed again at the next start. A step can also copy the
+ * rows into a new definition of the table. The rows are copied in batches,
+ * ordered by the key, each one in a savepoint together with the last key
+ * copied: memory does not depend on the size of the table, the progress is
+ * reported after each batch and a copy interrupted (even by a crash) goes on
+ * from the last batch at the next start.
+ *
+ * A table present without a version is taken as created with its last
+ * definition. A table with an unknown version, like a newer one, is never
+ * dropped: the migration fails.
+ */
+class SchemaMigrator : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(SchemaMigrator)
+
+public:
+    /*!
+     * \struct BSM::Data::SchemaMigrator::Step
+     * \brief Update of a table from the previous version.
+     */
+    struct Step
+    {
+        /*! Constructor of a step with only statements.
+         * \param version the version of the table after the step
+         * \param statements the SQL statements
+         */
+        Step(const int version, const QStringList& statements);
+
+        /*! Constructor of a step that copies the rows.
+         * \param version the version of the table after the step
+         * \param columns the new definition of the table
+         * \param keyColumns the columns of the old table that order the rows, unique
+         * \param select an expression on the old table for each column of the new one
+         * \param statements the SQL statements to execute after the copy
+         */
+        Step(const int version, const Utils::ColumnList& columns, const QStringList& keyColumns,
+             const QStringList& select, const QStringList& statements = QStringList());
+
+        int                 version;        //!< Version of the table after the step
+        QStringList         statements;     //!< SQL statements, after the copy if any
+        Utils::ColumnList   columns;        //!< New definition of the table, empty if the rows are not copied
+        QStringList         keyColumns;     //!< Unique columns of the old table that order the rows
+        QStringList         select;         //!< Expressions on the old table for the columns of the new one
+    };
+    //! List of steps
+    typedef QList<Step> StepList;
+
+    /*! Constructor of the class.
+     * \param parent the parent QObject
+     */
+    explicit SchemaMigrator(QObject* parent = 0);
+    virtual ~SchemaMigrator();
+
+    //! Get the number of rows copied in each savepoint.
+    int getBatchSize() const;
+
+    /*! Set the number of rows copied in each savepoint.
+     * \param batchSize the number of rows
+     */
+    void setBatchSize(const int batchSize);
+
+    /*! Create or update a table.
+     * \param tableName the name of the table
+     * \param columns the last definition of the table
+     * \param tableVersion the last version of the table
+     * \param steps the updates from each version, in any order
+     * \param withoutRowid \c true to create the table WITHOUT ROWID, see Utils::createTable()
+     * \return \c true on success or \c false on failure
+     */
+    bool migrate(const QString& tableName, const Utils::ColumnList& columns, const int tableVersion, const StepList& steps, const bool withoutRowid = false);
+
+signals:
+    /*! An update of a table was started.
+     * \param text the description of the update, for the user
+     */
+    void started(const QString& text);
+
+    /*! The update is in progress.
+     *
+     * A copy of the rows reports the progress after each batch.
+     * \param perc the percentage of the progress
+     */
+    void progress(const int perc);
+
+private:
+    //! Execute a step on a table.
+    bool runStep(const QString& tableName, const Step& step, const bool withoutRowid);
+    //! Copy the rows of a table into the definition of a step.
+    bool copyRows(const QString& tableName, const Step& step, const bool withoutRowid);
+    //! Execute some statements, stopping at the first failure.
+    bool runStatements(const QStringList& statements);
+
+    int m_batchSize;
+};
+
+} // namespace Data
+} // namespace BSM
+
+#endif // SCHEMAMIGRATOR_HPP
@@ -0,0 +1,118 @@
+/*!
+ * \file Timestamp.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the Timestamp class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "Timestamp.hpp"
+
+namespace BSM {
+namespace Data {
+
+//! Number of years in a scale date (7 bits)
+#define SCALE_YEARS         128
+//! First year of a scale date
+#define SCALE_FIRST_YEAR    1920
+//! Index in the table of January 1970
+#define EPOCH_MONTH         ((1970 - SCALE_FIRST_YEAR) * 12)
+//! Minutes in a day
+#define MINUTES_PER_DAY     1440
+
+const qint64 Timestamp::Invalid = Q_INT64_C(-0x7FFFFFFFFFFFFFFF) - 1;
+
+/*!
+ * \brief Days since 1920-01-01 of the first day of each month of the scale dates.
+ *
+ * The entry after the last month ends the table, so the length of each month
+ * is the difference with the next entry.
+ */
+struct ScaleMonthTable
+{
+    qint32 days[SCALE_YEARS * 12 + 1];  //!< Days of the first day of each month
+
+    ScaleMonthTable()
+    {
+        static const int monthDays[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+
+        qint32 total = 0;
+        for (int year = 0; year < SCALE_YEARS; ++year) {
+            int y = SCALE_FIRST_YEAR + year;
+            bool leap = (y % 4 == 0 && y % 100 != 0) || y % 400 == 0;
+            for (int month = 0; month < 12; ++month) {
+                days[year * 12 + month] = total;
+                total += monthDays[month] + ((leap && month == 1) ? 1 : 0);
+            }
+        }
+        days[SCALE_YEARS * 12] = total;
+    }
+};
+
+//! Get the table of the months, built at the first use.
+static const ScaleMonthTable& scaleMonthTable()
+{
+    static const ScaleMonthTable table;
+    return table;
+}
+
+qint64 Timestamp::scaleMinutes(const quint16 date, const uchar hours, const uchar minutes)
+{
+    if (date == 0 || date == 0xFFFF || hours > 23 || minutes > 59)
+        return Invalid;
+
+    int month = (date >> 5) & 0xF;
+    int day = date & 0x1F;
+    if (month < 1 || month > 12 || day < 1)
+        return Invalid;
+
+    const qint32* days = scaleMonthTable().days;
+    int index = (date >> 9) * 12 + month - 1;
+    if (day > days[index + 1] - days[index])
+        return Invalid;
+
+    qint64 epochDays = days[index] - days[EPOCH_MONTH] + day - 1;
+    return epochDays * MINUTES_PER_DAY + hours * 60 + minutes;
+}
+
+Timestamp Timestamp::fromDateTime(const QDateTime& dateTime)
+{
+    if (!dateTime.isValid())
+        return Timestamp();
+
+    static const QDate epoch(1970, 1, 1);
+    QTime time = dateTime.time();
+    return Timestamp(epoch.daysTo(dateTime.date()) * MINUTES_PER_DAY + time.hour() * 60 + time.minute());
+}
+
+QDateTime Timestamp::toDateTime() const
+{
+    if (!isValid())
+        return QDateTime();
+
+    qint64 days = m_minutes / MINUTES_PER_DAY;
+    int minutes = m_minutes % MINUTES_PER_DAY;
+    if (minutes < 0) {
+        --days;
+        minutes += MINUTES_PER_DAY;
+    }
+    return QDateTime(QDate(1970, 1, 1).addDays(days), QTime(minutes / 60, minutes % 60));
+}
+
+} // namespace Data
+} // namespace BSM
@@ -0,0 +1,113 @@
+/*!
+ * \file Timestamp.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the Timestamp class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TIMESTAMP_HPP
+#define TIMESTAMP_HPP
+
+#include <QtCore/QtGlobal>
+#include <QtCore/QDateTime>
+
+namespace BSM {
+namespace Data {
+
+/*!
+ * \class BSM::Data::Timestamp
+ * \brief Date and time of a measurement, in minutes since the epoch.
+ *
+ * The scale has a resolution of one minute and no time zone, so a timestamp
+ * is the number of minutes from 1970-01-01 00:00 of the local time. Sorting,
+ * comparisons and ranges are plain integer operations; QDateTime is used only
+ * to show the values or to store them on the DB.
+ *
+ * The invalid timestamp is less than all the valid ones.
+ */
+class Timestamp
+{
+public:
+    //! Value of an invalid timestamp.
+    static const qint64 Invalid;
+
+    //! Constructor of an invalid timestamp.
+    Timestamp()
+        : m_minutes(Invalid)
+    {}
+
+    /*! Constructor of the class.
+     * \param minutes the minutes since the epoch, or Invalid
+     */
+    explicit Timestamp(const qint64 minutes)
+        : m_minutes(minutes)
+    {}
+
+    /*! Convert a date and time of the scale.
+     *
+     * The date word has 7 bits for the year (starting from the 1920), 4 bits for
+     * the month and 5 bits for the day. The conversion is a lookup in a table
+     * of the days since 1920 for each month.
+     * \param date the date word
+     * \param hours the hours
+     * \param minutes the minutes
+     * \return the minutes since the epoch, or Invalid
+     */
+    static qint64 scaleMinutes(const quint16 date, const uchar hours, const uchar minutes);
+
+    /*! Convert a QDateTime.
+     * \param dateTime the date and time
+     * \return the timestamp, invalid if \p dateTime is not valid
+     */
+    static Timestamp fromDateTime(const QDateTime& dateTime);
+
+    //! Check if the timestamp is valid.
+    bool isValid() const
+    {
+        return m_minutes != Invalid;
+    }
+
+    //! Get the minutes since the epoch.
+    qint64 toMinutes() const
+    {
+        return m_minutes;
+    }
+
+    /*! Convert to QDateTime.
+     * \return the date and time, or a \c null QDateTime if invalid
+     */
+    QDateTime toDateTime() const;
+
+    bool operator==(const Timestamp& other) const { return m_minutes == other.m_minutes; }  //!< Equal operator
+    bool operator!=(const Timestamp& other) const { return m_minutes != other.m_minutes; }  //!< Not equal operator
+    bool operator<(const Timestamp& other) const  { return m_minutes <  other.m_minutes; }  //!< Less than operator
+    bool operator>(const Timestamp& other) const  { return m_minutes >  other.m_minutes; }  //!< Greater than operator
+    bool operator<=(const Timestamp& other) const { return m_minutes <= other.m_minutes; }  //!< Less or equal than operator
+    bool operator>=(const Timestamp& other) const { return m_minutes >= other.m_minutes; }  //!< Greater or equal than operator
+
+private:
+    qint64 m_minutes;
+};
+
+} // namespace Data
+} // namespace BSM
+
+Q_DECLARE_TYPEINFO(BSM::Data::Timestamp, Q_PRIMITIVE_TYPE);
+
+#endif // TIMESTAMP_HPP
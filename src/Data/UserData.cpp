@@ -23,6 +23,8 @@
 
 #include "UserData.hpp"
 
+#include <QtCore/QtAlgorithms>
+
 namespace BSM {
 namespace Data {
 
@@ -33,6 +35,9 @@ UserData::UserData(QObject* parent)
     , m_gender(Unknown)
     , m_activity(None)
 {
+    m_cursor.timestamp = Timestamp::Invalid;
+    m_cursor.count = 0;
+    m_cursor.pointer = 0;
 }
 
 UserData::~UserData()
@@ -102,14 +107,52 @@ void UserData::setActivity(const UserData::Activity& activity)
     m_activity = activity;
 }
 
+/*! Check if a measurement is older than a timestamp.
+ * \param m the measurement
+ * \param timestamp the timestamp
+ * \return \c true if the measurement is older
+ */
+static bool isBefore(const UserMeasurement* m, const Timestamp& timestamp)
+{
+    return m->getTimestamp() < timestamp;
+}
+
+/*! Check if a measurement is older than another one.
+ * \param m1 the first measurement
+ * \param m2 the second measurement
+ * \return \c true if the first measurement is older
+ */
+static bool isOlder(const UserMeasurement* m1, const UserMeasurement* m2)
+{
+    return m1->getTimestamp() < m2->getTimestamp();
+}
+
 UserMeasurementList& UserData::getMeasurements()
 {
     return m_measurements;
 }
 
+UserMeasurementRange UserData::getMeasurementRange(const Timestamp& from, const Timestamp& to) const
+{
+    UserMeasurementList::const_iterator begin = qLowerBound(m_measurements.constBegin(), m_measurements.constEnd(), from, isBefore);
+    UserMeasurementList::const_iterator end = to.isValid() ? qLowerBound(begin, m_measurements.constEnd(), to, isBefore) : m_measurements.constEnd();
+    return UserMeasurementRange(begin, end);
+}
+
 void UserData::setMeasurements(const UserMeasurementList& measurements)
 {
     m_measurements = measurements;
+    qStableSort(m_measurements.begin(), m_measurements.end(), isOlder);
+}
+
+SampleCursor UserData::getCursor() const
+{
+    return m_cursor;
+}
+
+void UserData::setCursor(const SampleCursor& cursor)
+{
+    m_cursor = cursor;
 }
 
 QDebug operator<<(QDebug dbg, const UserData& ud)
@@ -30,6 +30,7 @@
 #include <QtCore/QList>
 
 #include <Data/UserMeasurement.hpp>
+#include <Data/SampleCursor.hpp>
 
 namespace BSM {
 namespace Data {
@@ -131,10 +132,29 @@ public:
     Activity getActivity() const;
 
     /*! Getter for the measurements property.
-     * \sa UserMeasurement UserMeasurementList measurements setMeasurements
+     *
+     * The measurements are ordered by timestamp, from the oldest one: the new
+     * ones must be appended in order.
+     * \sa UserMeasurement UserMeasurementList measurements setMeasurements getMeasurementRange
      */
     UserMeasurementList& getMeasurements();
 
+    /*! Get the measurements in a range of time.
+     *
+     * The ends of the range are found by binary search, so only the
+     * measurements in the range are visited.
+     * \param from the first timestamp of the range, invalid for no lower limit
+     * \param to the timestamp after the range, invalid for no upper limit
+     * \return the range of the measurements property
+     * \sa getMeasurements
+     */
+    UserMeasurementRange getMeasurementRange(const Timestamp& from, const Timestamp& to) const;
+
+    /*! Get the position of the user in the samples of the scale.
+     * \sa setCursor
+     */
+    SampleCursor getCursor() const;
+
     /*! Get gender as string.
      * Retrieves the gender as a single character string: \c M or \c F.
      * A \c ? is returned if an invalid gender is set.
@@ -175,11 +195,17 @@ public slots:
     void setActivity(const Activity& activity);
 
     /*! Setter for the measurements property.
-     * \param measurements the new value
+     * \param measurements the new value, it is ordered by timestamp
      * \sa UserMeasurement UserMeasurementList measurements getMeasurements
      */
     void setMeasurements(const UserMeasurementList& measurements);
 
+    /*! Set the position of the user in the samples of the scale.
+     * \param cursor the new value
+     * \sa getCursor
+     */
+    void setCursor(const SampleCursor& cursor);
+
 protected:
     uchar               m_id;           //!< id property value.             \sa id getId setId
     QDate               m_birthDate;    //!< birthDate property value.      \sa birthDate getBirthDate setBirthDate
@@ -187,6 +213,7 @@ protected:
     Gender              m_gender;       //!< gender property value.         \sa Gender gender getGender setGender getGenderString
     Activity            m_activity;     //!< activity property value.       \sa Activity activity getActivity setActivity
     UserMeasurementList m_measurements; //!< measurements property values.  \sa measurements getMeasurements setMeasurements
+    SampleCursor        m_cursor;       //!< position in the samples.       \sa getCursor setCursor
 
     friend QDebug operator<<(QDebug dbg, const UserData& ud);
 };
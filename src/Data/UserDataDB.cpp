@@ -22,17 +22,39 @@
  */
 
 #include "UserDataDB.hpp"
+#include "UserMeasurementDB.hpp"
+#include "MeasurementRollupDB.hpp"
+#include "SchemaMigrator.hpp"
+#include "DbWorker.hpp"
 
 #include <utils.hpp>
 #include <Usb/UsbData.hpp>
 
 #include <QtSql/QSqlQuery>
+#include <QtSql/QSqlRecord>
 
 namespace BSM {
 namespace Data {
 
+//! Columns loaded by UserDataDB::loadAll(), in the order of UserDataColumn
+#define USER_DATA_COLUMNS "id, name, birthDate, height, gender, activity, lastDownload, cursorTimestamp, cursorCount, cursorPointer"
+
+//! Indices of the columns in USER_DATA_COLUMNS
+enum UserDataColumn {
+    IdColumn,
+    NameColumn,
+    BirthDateColumn,
+    HeightColumn,
+    GenderColumn,
+    ActivityColumn,
+    LastDownloadColumn,
+    CursorTimestampColumn,
+    CursorCountColumn,
+    CursorPointerColumn
+};
+
 const QString UserDataDB::tableName = "UserData";
-const uint UserDataDB::tableVersion = 1;
+const uint UserDataDB::tableVersion = 2;
 
 UserDataDB::UserDataDB(QObject* parent)
     : UserData(parent)
@@ -48,22 +70,8 @@ QString UserDataDB::getName() const
     return m_name;
 }
 
-bool UserDataDB::createTable()
+bool UserDataDB::createTable(SchemaMigrator& migrator)
 {
-    int version = Utils::getTableVersion(tableName);
-
-    // Check if table is already present and updated
-    if (version == tableVersion)
-        return true;
-
-    // Updates of the table will go here
-
-    // Unknown version: drop and start again!
-    // WARNING: all data will be lost, prompt the user?
-    if (!Utils::dropTable(tableName))
-        return false;
-
-    // Create table
     Utils::ColumnList columns;
     columns.append(Utils::Column("id", "INTEGER PRIMARY KEY NOT NULL"));
     columns.append(Utils::Column("name", "TEXT NOT NULL"));
@@ -72,14 +80,20 @@ bool UserDataDB::createTable()
     columns.append(Utils::Column("gender", "INTEGER NOT NULL"));
     columns.append(Utils::Column("activity", "INTEGER NOT NULL"));
     columns.append(Utils::Column("lastDownload", "TEXT NOT NULL"));
-    if (!Utils::createTable(tableName, columns))
-        return false;
-
-    // Save table version
-    if (!Utils::setTableVersion(tableName, tableVersion))
-        return false;
-
-    return true;
+    columns.append(Utils::Column("cursorTimestamp", "INTEGER"));
+    columns.append(Utils::Column("cursorCount", "INTEGER NOT NULL DEFAULT 0"));
+    columns.append(Utils::Column("cursorPointer", "INTEGER NOT NULL DEFAULT 0"));
+
+    // Updates of the table
+    SchemaMigrator::StepList steps;
+    // Version 2: cursor of the samples
+    steps.append(SchemaMigrator::Step(2, QStringList()
+        << "ALTER TABLE " + tableName + " ADD COLUMN cursorTimestamp INTEGER;"
+        << "ALTER TABLE " + tableName + " ADD COLUMN cursorCount INTEGER NOT NULL DEFAULT 0;"
+        << "ALTER TABLE " + tableName + " ADD COLUMN cursorPointer INTEGER NOT NULL DEFAULT 0;"
+    ));
+
+    return migrator.migrate(tableName, columns, tableVersion, steps);
 }
 
 UserDataDBList UserDataDB::loadAll()
@@ -87,7 +101,7 @@ UserDataDBList UserDataDB::loadAll()
     UserDataDBList list;
 
     QSqlQuery query;
-    if (!query.prepare("SELECT * FROM " + tableName + " ORDER BY name;")) {
+    if (!Utils::prepareQuery(query, "SELECT " USER_DATA_COLUMNS " FROM " + tableName + " ORDER BY name;", Utils::database(Utils::ReadOnly))) {
         qCritical() << "Cannot prepare query for UserDataDB::loadAll()";
         return list;
     }
@@ -97,7 +111,7 @@ UserDataDBList UserDataDB::loadAll()
     }
     while (query.next()) {
         UserDataDB* ud = new UserDataDB();
-        if (ud->parse(query.record())) {
+        if (ud->parse(query)) {
             list.append(ud);
         }
         else {
@@ -110,59 +124,43 @@ UserDataDBList UserDataDB::loadAll()
     return list;
 }
 
-bool UserDataDB::parse(const QSqlRecord& record)
+bool UserDataDB::parse(const QSqlQuery& query)
 {
     QVariant value;
     bool ok;
 
-    value = record.value("id");
-    if (!value.isValid())
-        return false;
-    m_id = value.toUInt(&ok);
+    m_id = query.value(IdColumn).toUInt(&ok);
     if (!ok)
         return false;
 
-    value = record.value("name");
-    if (!value.isValid())
-        return false;
-    m_name = value.toString();
-
-    value = record.value("birthDate");
-    if (!value.isValid())
-        return false;
-    m_birthDate = value.toDate();
+    m_name = query.value(NameColumn).toString();
+    m_birthDate = query.value(BirthDateColumn).toDate();
 
-    value = record.value("height");
-    if (!value.isValid())
-        return false;
-    m_height = value.toUInt(&ok);
+    m_height = query.value(HeightColumn).toUInt(&ok);
     if (!ok)
         return false;
 
-    value = record.value("gender");
-    if (!value.isValid())
-        return false;
-    unsigned gender = value.toUInt(&ok);
+    unsigned gender = query.value(GenderColumn).toUInt(&ok);
     if (!ok)
         return false;
     if (gender < UserData::Male || gender > UserData::Female)
         return false;
     m_gender = (UserData::Gender) gender;
 
-    value = record.value("activity");
-    if (!value.isValid())
-        return false;
-    unsigned activity = value.toUInt(&ok);
+    unsigned activity = query.value(ActivityColumn).toUInt(&ok);
     if (!ok)
         return false;
     if (activity > UserData::VeryHigh)
         return false;
     m_activity = (UserData::Activity) activity;
 
-    value = record.value("lastDownload");
-    if (!value.isValid())
-        return false;
-    m_lastDownload = value.toDateTime();
+    m_lastDownload = query.value(LastDownloadColumn).toDateTime();
+
+    // A missing cursor only means that all the samples are decoded
+    value = query.value(CursorTimestampColumn);
+    m_cursor.timestamp = value.isNull() ? Timestamp::Invalid : value.toLongLong();
+    m_cursor.count = query.value(CursorCountColumn).toUInt();
+    m_cursor.pointer = query.value(CursorPointerColumn).toUInt();
 
     return true;
 }
@@ -182,6 +180,13 @@ void UserDataDB::setLastDownload(const QDateTime& lastDownload)
     m_lastDownload = lastDownload;
 }
 
+UserMeasurementRange UserDataDB::getNewMeasurements(const BSM::Data::UserData& userData) const
+{
+    Timestamp lastDownload = Timestamp::fromDateTime(m_lastDownload);
+    Timestamp from = lastDownload.isValid() ? Timestamp(lastDownload.toMinutes() + 1) : Timestamp();
+    return userData.getMeasurementRange(from, Timestamp());
+}
+
 bool UserDataDB::merge(const QDateTime& scaleDateTime, BSM::Data::UserData& userData)
 {
     if (userData.getId()        != m_id        ||
@@ -192,42 +197,41 @@ bool UserDataDB::merge(const QDateTime& scaleDateTime, BSM::Data::UserData& user
     )
         return false; // Not the correct user, something changed on the scale?
 
-    // Import measurements
-    foreach(UserMeasurement* m, userData.getMeasurements()) {
-        if (m->getDateTime() > m_lastDownload)
-            m_measurements.append(new UserMeasurement(m, this));
-    }
-    // Save lastDownload
+    // Import measurements, the ones after the last download
+    UserMeasurementRange range = getNewMeasurements(userData);
+    // They are not kept in memory: the models load them from the DB
+    UserMeasurementList added;
+    for (UserMeasurementList::const_iterator it = range.first; it != range.second; ++it)
+        added.append(*it);
+    // Save lastDownload and the cursor for the next one
     m_lastDownload = scaleDateTime;
+    m_cursor = userData.getCursor();
 
-    // Save new data
-    return save();
+    // Save new data, with the rollups, in a single transaction
+    if (!DbWorker::beginBatch())
+        return false;
+    bool saved = save() && UserMeasurementDB::insert(m_id, added) && MeasurementRollupDB::update(m_id, added);
+    bool committed = DbWorker::endBatch();
+    return saved && committed;
 }
 
 bool UserDataDB::save() const
 {
-    QSqlQuery query;
-    if (!query.prepare("INSERT OR REPLACE INTO " + tableName +
-                               " ( id,  name,  birthDate,  height,  gender,  activity,  lastDownload)"
-                        " VALUES (:id, :name, :birthDate, :height, :gender, :activity, :lastDownload);")) {
-        qCritical() << "Cannot prepare query for UserDataDB::save()";
-        return false;
-    }
-    query.bindValue(":id", m_id);
-    query.bindValue(":name", m_name);
-    query.bindValue(":birthDate", m_birthDate);
-    query.bindValue(":height", m_height);
-    query.bindValue(":gender", m_gender);
-    query.bindValue(":activity", m_activity);
-    query.bindValue(":lastDownload", m_lastDownload);
-    if (!query.exec()) {
-        qCritical() << "Cannot execute query for UserDataDB::save()";
-        return false;
-    }
-
-    // TODO Save measurements
-
-    return true;
+    DbJob job("UserDataDB::save()", "INSERT OR REPLACE INTO " + tableName +
+                   " ( id,  name,  birthDate,  height,  gender,  activity,  lastDownload,  cursorTimestamp,  cursorCount,  cursorPointer)"
+            " VALUES (:id, :name, :birthDate, :height, :gender, :activity, :lastDownload, :cursorTimestamp, :cursorCount, :cursorPointer);");
+    job.bindValue(":id", m_id);
+    job.bindValue(":name", m_name);
+    job.bindValue(":birthDate", m_birthDate);
+    job.bindValue(":height", m_height);
+    job.bindValue(":gender", m_gender);
+    job.bindValue(":activity", m_activity);
+    job.bindValue(":lastDownload", m_lastDownload);
+    job.bindValue(":cursorTimestamp", m_cursor.timestamp == Timestamp::Invalid ? QVariant(QVariant::LongLong) : QVariant(m_cursor.timestamp));
+    job.bindValue(":cursorCount", m_cursor.count);
+    job.bindValue(":cursorPointer", m_cursor.pointer);
+
+    return DbWorker::submit(job);
 }
 
 QDebug operator<<(QDebug dbg, const UserDataDB& ud)
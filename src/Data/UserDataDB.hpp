@@ -26,7 +26,7 @@
 
 #include <Data/UserData.hpp>
 
-#include <QtSql/QSqlRecord>
+#include <QtSql/QSqlQuery>
 
 namespace BSM {
 
@@ -36,6 +36,7 @@ namespace Usb {
 
 namespace Data {
 
+class SchemaMigrator;
 class UserDataDB;
 //! List of user data
 typedef QList<UserDataDB*> UserDataDBList;
@@ -71,10 +72,11 @@ public:
     explicit UserDataDB(QObject* parent = 0);
     virtual ~UserDataDB();
 
-    /*! Create the DB table.
+    /*! Create or update the DB table.
+     * \param migrator the migrator of the tables
      * \return \c true on success or \c false on failure
      */
-    static bool createTable();
+    static bool createTable(SchemaMigrator& migrator);
 
     //! Name of the DB table.
     static const QString tableName;
@@ -82,7 +84,10 @@ public:
     //! Version of the table
     static const uint tableVersion;
 
-    /*! Load all user data from the DB
+    /*! Load all user data from the DB.
+     *
+     * The measurements are not loaded: they are read in pages by the
+     * Models::UserMeasurementModel.
      * \return the list of user data as UserDataDBList
      */
     static UserDataDBList loadAll();
@@ -97,19 +102,30 @@ public:
      */
     QDateTime getLastDownload() const;
 
+    /*! Get the measurements taken after the last download.
+     * \param userData the user data from the USB scale
+     * \return the range of the measurements that merge() would insert
+     */
+    UserMeasurementRange getNewMeasurements(const BSM::Data::UserData& userData) const;
+
     /*! Merge data from USB.
      *
      * The data received from the USB scale are merged with the current data for
-     * the user. The data prior to the last download date and time are ignored.
+     * the user. The data prior to the last download date and time are ignored,
+     * the new measurements are inserted on the DB, with their rollups, and not
+     * kept in memory. The writes are queued to the DbWorker in a single batch.
      * \param scaleDateTime the date and time of the scale for the last download
      * \param userData the user data from the USB scale
-     * \return \c true on success or \c false on failure
+     * \return \c true if the writes were queued or \c false on failure
      * \sa UserData
      */
     bool merge(const QDateTime& scaleDateTime, BSM::Data::UserData& userData);
 
     /*! Save data on DB.
-     * \return \c true on success or \c false on failure
+     *
+     * The measurements are not saved: they are inserted when merged. The write
+     * is queued to the DbWorker, with a copy of the data.
+     * \return \c true if the write was queued or \c false on failure
      */
     bool save() const;
 
@@ -130,11 +146,13 @@ protected:
     QString     m_name;         //!< name property value.           \sa name getName setName
     QDateTime   m_lastDownload; //!< lastDownload property value.   \sa lastDownload getLastDownload setLastDownload
 
-    /*! Parse a QSqlRecord into the UserDataDB object
-     * \param record the QSqlRecord to parse
+    /*! Parse the current row of a query into the UserDataDB object
+     *
+     * The columns are read by index, in the order selected by loadAll().
+     * \param query the query on the row to parse
      * \return \c true on success or \c false on failure
      */
-    bool parse(const QSqlRecord& record);
+    bool parse(const QSqlQuery& query);
 
     friend QDebug operator<<(QDebug dbg, const UserDataDB& ud);
 };
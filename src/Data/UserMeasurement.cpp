@@ -37,7 +37,7 @@ UserMeasurement::UserMeasurement(QObject* parent)
 
 UserMeasurement::UserMeasurement(const UserMeasurement* other, QObject* parent)
     : QObject(parent)
-    , m_dateTime(other->m_dateTime)
+    , m_timestamp(other->m_timestamp)
     , m_weight(other->m_weight)
     , m_bodyFatPercent(other->m_bodyFatPercent)
     , m_waterPercent(other->m_waterPercent)
@@ -51,32 +51,42 @@ UserMeasurement::~UserMeasurement()
 
 bool UserMeasurement::operator<(const UserMeasurement& other)
 {
-    return (m_dateTime < other.m_dateTime);
+    return (m_timestamp < other.m_timestamp);
 }
 
 bool UserMeasurement::operator>(const UserMeasurement& other)
 {
-    return (m_dateTime > other.m_dateTime);
+    return (m_timestamp > other.m_timestamp);
 }
 
 bool UserMeasurement::operator<=(const UserMeasurement& other)
 {
-    return (m_dateTime <= other.m_dateTime);
+    return (m_timestamp <= other.m_timestamp);
 }
 
 bool UserMeasurement::operator>=(const UserMeasurement& other)
 {
-    return (m_dateTime >= other.m_dateTime);
+    return (m_timestamp >= other.m_timestamp);
 }
 
 QDateTime UserMeasurement::getDateTime() const
 {
-    return m_dateTime;
+    return m_timestamp.toDateTime();
 }
 
 void UserMeasurement::setDateTime(const QDateTime& dateTime)
 {
-    m_dateTime = dateTime;
+    m_timestamp = Timestamp::fromDateTime(dateTime);
+}
+
+Timestamp UserMeasurement::getTimestamp() const
+{
+    return m_timestamp;
+}
+
+void UserMeasurement::setTimestamp(const Timestamp& timestamp)
+{
+    m_timestamp = timestamp;
 }
 
 double UserMeasurement::getWeight() const
@@ -125,7 +135,7 @@ QDebug operator<<(QDebug dbg, const UserMeasurement& um)
     return dbg;
 #else
     dbg.nospace() << "Data::UserMeasurement("
-                  << um.m_dateTime.toString() << " - "
+                  << um.m_timestamp.toDateTime().toString() << " - "
                   << um.m_weight << "kg, "
                   << um.m_bodyFatPercent << "%, "
                   << um.m_waterPercent << "%, "
@@ -28,6 +28,9 @@
 #include <QtCore/QDebug>
 #include <QtCore/QDateTime>
 #include <QtCore/QList>
+#include <QtCore/QPair>
+
+#include <Data/Timestamp.hpp>
 
 namespace BSM {
 namespace Data {
@@ -102,6 +105,11 @@ public:
      */
     QDateTime getDateTime() const;
 
+    /*! Get the date and the time as a timestamp.
+     * \sa dateTime setTimestamp
+     */
+    Timestamp getTimestamp() const;
+
     /*! Getter for the weight property.
      * \sa weight setWeight
      */
@@ -129,6 +137,12 @@ public slots:
      */
     void setDateTime(const QDateTime& dateTime);
 
+    /*! Set the date and the time as a timestamp.
+     * \param timestamp the new value
+     * \sa dateTime getTimestamp
+     */
+    void setTimestamp(const Timestamp& timestamp);
+
     /*! Setter for the weight property.
      * \param weight the new value
      * \sa weight getWeight
@@ -154,7 +168,7 @@ public slots:
     void setMusclePercent(const double& musclePercent);
 
 protected:
-    QDateTime   m_dateTime;         //!< dateTime property value.       \sa dateTime getDateTime setDateTime
+    Timestamp   m_timestamp;        //!< dateTime property value.       \sa dateTime getDateTime setDateTime getTimestamp setTimestamp
     double      m_weight;           //!< weight property value.         \sa weight getWeight setWeight
     double      m_bodyFatPercent;   //!< bodyFatPercent property value. \sa bodyFatPercent getBodyFatPercent setBodyFatPercent
     double      m_waterPercent;     //!< waterPercent property value.   \sa waterPercent getWaterPercent setWaterPercent
@@ -179,6 +193,9 @@ QDebug operator<<(QDebug dbg, const UserMeasurement* um);
 //! List of measurements
 typedef QList<UserMeasurement*> UserMeasurementList;
 
+//! Range of a list of measurements, from the first one to the one past the last.
+typedef QPair<UserMeasurementList::const_iterator, UserMeasurementList::const_iterator> UserMeasurementRange;
+
 } // namespace Data
 } // namespace BSM
 
@@ -0,0 +1,160 @@
+/*!
+ * \file UserMeasurementDB.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UserMeasurementDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UserMeasurementDB.hpp"
+#include "SchemaMigrator.hpp"
+#include "DbWorker.hpp"
+
+#include <utils.hpp>
+
+#include <QtCore/QVariant>
+#include <QtSql/QSqlQuery>
+
+namespace BSM {
+namespace Data {
+
+//! Columns of a measurement, decoded by index
+#define MEASUREMENT_COLUMNS "timestamp, weight, bodyFat, water, muscle"
+
+const QString UserMeasurementDB::tableName = "Measurement";
+const uint UserMeasurementDB::tableVersion = 1;
+
+/*! Convert a value to tenths, as sent by the scale.
+ * \param value the value
+ * \return the value in tenths
+ */
+static inline int toTenths(const double value)
+{
+    return qRound(value * 10);
+}
+
+bool UserMeasurementDB::createTable(SchemaMigrator& migrator)
+{
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("userId", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("timestamp", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("weight", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("bodyFat", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("water", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("muscle", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("PRIMARY KEY", "(userId, timestamp)"));
+
+    // The rows are small and always read by their key: store them in the key
+    return migrator.migrate(tableName, columns, tableVersion, SchemaMigrator::StepList(), true);
+}
+
+bool UserMeasurementDB::insert(const uint userId, const UserMeasurementList& measurements)
+{
+    if (measurements.isEmpty())
+        return true;
+
+    QVariantList userIds, timestamps, weights, bodyFats, waters, muscles;
+    foreach(const UserMeasurement* m, measurements) {
+        userIds << userId;
+        timestamps << m->getTimestamp().toMinutes();
+        weights << toTenths(m->getWeight());
+        bodyFats << toTenths(m->getBodyFatPercent());
+        waters << toTenths(m->getWaterPercent());
+        muscles << toTenths(m->getMusclePercent());
+    }
+
+    DbJob job("UserMeasurementDB::insert()", "INSERT OR IGNORE INTO " + tableName +
+                   " ( userId,  timestamp,  weight,  bodyFat,  water,  muscle)"
+            " VALUES (:userId, :timestamp, :weight, :bodyFat, :water, :muscle);", true);
+    job.bindValue(":userId", userIds);
+    job.bindValue(":timestamp", timestamps);
+    job.bindValue(":weight", weights);
+    job.bindValue(":bodyFat", bodyFats);
+    job.bindValue(":water", waters);
+    job.bindValue(":muscle", muscles);
+
+    return DbWorker::submit(job);
+}
+
+/*! Decode the current row of a query.
+ * \param query the query, with the columns of MEASUREMENT_COLUMNS
+ * \param parent the parent QObject of the measurement
+ * \return the measurement
+ */
+static UserMeasurement* decodeMeasurement(const QSqlQuery& query, QObject* parent)
+{
+    UserMeasurement* m = new UserMeasurement(parent);
+    m->setTimestamp(Timestamp(query.value(0).toLongLong()));
+    m->setWeight(query.value(1).toInt() * 0.1);
+    m->setBodyFatPercent(query.value(2).toInt() * 0.1);
+    m->setWaterPercent(query.value(3).toInt() * 0.1);
+    m->setMusclePercent(query.value(4).toInt() * 0.1);
+    return m;
+}
+
+int UserMeasurementDB::loadRange(const uint userId, const Timestamp& from, const Timestamp& to, UserMeasurementList& measurements, QObject* parent)
+{
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT " MEASUREMENT_COLUMNS " FROM " + tableName +
+                       " WHERE userId = :userId AND timestamp >= :from AND timestamp < :to ORDER BY timestamp;", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for UserMeasurementDB::loadRange()";
+        return -1;
+    }
+    query.bindValue(":userId", userId);
+    query.bindValue(":from", from.isValid() ? from.toMinutes() : Timestamp::Invalid);
+    query.bindValue(":to", to.isValid() ? to.toMinutes() : Q_INT64_C(0x7FFFFFFFFFFFFFFF));
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for UserMeasurementDB::loadRange()";
+        return -1;
+    }
+    int loaded = 0;
+    while (query.next()) {
+        measurements.append(decodeMeasurement(query, parent));
+        ++loaded;
+    }
+
+    return loaded;
+}
+
+int UserMeasurementDB::loadPage(const uint userId, const Timestamp& before, const int count, UserMeasurementList& measurements, QObject* parent)
+{
+    // The pages follow the key, no rows are skipped
+    QSqlQuery query;
+    if (!Utils::prepareQuery(query, "SELECT " MEASUREMENT_COLUMNS " FROM " + tableName +
+                       " WHERE userId = :userId AND timestamp < :before ORDER BY timestamp DESC LIMIT :count;", Utils::database(Utils::ReadOnly))) {
+        qCritical() << "Cannot prepare query for UserMeasurementDB::loadPage()";
+        return -1;
+    }
+    query.bindValue(":userId", userId);
+    query.bindValue(":before", before.isValid() ? before.toMinutes() : Q_INT64_C(0x7FFFFFFFFFFFFFFF));
+    query.bindValue(":count", count);
+    if (!query.exec()) {
+        qCritical() << "Cannot execute query for UserMeasurementDB::loadPage()";
+        return -1;
+    }
+    int loaded = 0;
+    while (query.next()) {
+        measurements.append(decodeMeasurement(query, parent));
+        ++loaded;
+    }
+
+    return loaded;
+}
+
+} // namespace Data
+} // namespace BSM
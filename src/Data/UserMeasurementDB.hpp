@@ -0,0 +1,103 @@
+/*!
+ * \file UserMeasurementDB.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UserMeasurementDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USERMEASUREMENTDB_HPP
+#define USERMEASUREMENTDB_HPP
+
+#include <Data/UserData.hpp>
+
+namespace BSM {
+namespace Data {
+
+class SchemaMigrator;
+
+/*!
+ * \class BSM::Data::UserMeasurementDB
+ * \brief Storage on the DB of the measurements of the users.
+ *
+ * The measurements are keyed by the ID of the user and by their timestamp,
+ * in minutes since the epoch; the values are saved in tenths, as they are
+ * sent by the scale. The key is the clustered index of the table, so the
+ * measurements of a user in a range of time are read with a range scan.
+ *
+ * The measurements are read by range or by page, never as a whole table: the
+ * users load only the measurements shown.
+ *
+ * The measurements are inserted in batches with a single prepared statement:
+ * the caller should open a transaction for the whole download, so the DB is
+ * synced only once.
+ */
+class UserMeasurementDB
+{
+public:
+    /*! Create or update the DB table.
+     * \param migrator the migrator of the tables
+     * \return \c true on success or \c false on failure
+     */
+    static bool createTable(SchemaMigrator& migrator);
+
+    //! Name of the DB table.
+    static const QString tableName;
+
+    //! Version of the table
+    static const uint tableVersion;
+
+    /*! Insert the measurements of a user.
+     *
+     * The measurements already present, with the same timestamp, are kept.
+     * The write is queued to the DbWorker, with a copy of the values.
+     * \param userId the ID of the user
+     * \param measurements the measurements to insert
+     * \return \c true if the write was queued or \c false on failure
+     */
+    static bool insert(const uint userId, const UserMeasurementList& measurements);
+
+    /*! Load the measurements of a user in a range of time, from the oldest one.
+     *
+     * The rows are read with a range scan of the primary key (userId,
+     * timestamp): the table has no rowid, so the key is the clustered index
+     * and only the rows returned are read.
+     * \param userId the ID of the user
+     * \param from the first timestamp of the range, invalid for no lower limit
+     * \param to the timestamp after the range, invalid for no upper limit
+     * \param measurements the list where the measurements are appended
+     * \param parent the parent QObject of the measurements
+     * \return the number of measurements loaded, \c -1 on failure
+     */
+    static int loadRange(const uint userId, const Timestamp& from, const Timestamp& to, UserMeasurementList& measurements, QObject* parent = 0);
+
+    /*! Load a page of the measurements of a user, from the newest one.
+     * \param userId the ID of the user
+     * \param before only the measurements older than this are loaded, all if invalid
+     * \param count the maximum number of measurements to load
+     * \param measurements the list where the measurements are appended
+     * \param parent the parent QObject of the measurements
+     * \return the number of measurements loaded, \c -1 on failure
+     */
+    static int loadPage(const uint userId, const Timestamp& before, const int count, UserMeasurementList& measurements, QObject* parent = 0);
+};
+
+} // namespace Data
+} // namespace BSM
+
+#endif // USERMEASUREMENTDB_HPP
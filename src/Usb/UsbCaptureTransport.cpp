@@ -0,0 +1,173 @@
+/*!
+ * \file UsbCaptureTransport.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbCaptureTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbCaptureTransport.hpp"
+
+#include <string.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QDateTime>
+#include <QtCore/QHash>
+#include <QtCore/QVector>
+#include <QtCore/QtEndian>
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \class BSM::Usb::UsbCaptureTransport::Recorder
+ * \brief Listener that writes the completed downloads and forwards all the events.
+ * \private
+ */
+class UsbCaptureTransport::Recorder : public UsbTransport::Listener
+{
+public:
+    Recorder(QFile& file, const bool chunks, Listener* listener)
+        : m_file(file)
+        , m_withChunks(chunks)
+        , m_listener(listener)
+    {}
+
+    virtual void transportStarted(const QString& device)
+    {
+        m_chunks.insert(device, QVector<quint32>());
+        m_listener->transportStarted(device);
+    }
+
+    virtual void transportReceived(const QString& device, const unsigned char* data, const int size)
+    {
+        QVector<quint32>& chunks = m_chunks[device];
+        if (chunks.size() < USB_CAPTURE_MAX_CHUNKS && (chunks.isEmpty() || (quint32) size > chunks.last()))
+            chunks.append(size);
+        m_listener->transportReceived(device, data, size);
+    }
+
+    virtual void transportCompleted(const QString& device, const unsigned char* data, const int size)
+    {
+        if (m_file.isOpen()) {
+            QVector<quint32> chunks;
+            if (m_withChunks)
+                chunks = m_chunks.value(device);
+            QByteArray id = device.toUtf8();
+            QByteArray header(USB_CAPTURE_HEADER_LEN + 4 * chunks.size(), 0);
+            uchar* ptr = (uchar*) header.data();
+            qToLittleEndian<qint64>(QDateTime::currentMSecsSinceEpoch(), ptr);
+            qToLittleEndian<quint32>(size, ptr + 8);
+            qToLittleEndian<quint16>(id.size(), ptr + 12);
+            qToLittleEndian<quint16>(chunks.size(), ptr + 14);
+            for (int i = 0; i < chunks.size(); ++i)
+                qToLittleEndian<quint32>(qMin<quint32>(chunks.at(i), size), ptr + USB_CAPTURE_HEADER_LEN + 4 * i);
+            if (m_file.write(header.constData(), USB_CAPTURE_HEADER_LEN) != USB_CAPTURE_HEADER_LEN ||
+                m_file.write(id) != id.size() ||
+                m_file.write(header.constData() + USB_CAPTURE_HEADER_LEN, 4 * chunks.size()) != 4 * chunks.size() ||
+                m_file.write((const char*) data, size) != size ||
+                !m_file.flush()
+            ) {
+                qWarning() << "Cannot write capture file" << m_file.fileName();
+            }
+        }
+        m_listener->transportCompleted(device, data, size);
+    }
+
+    virtual void transportError(const QString& device)
+    {
+        m_listener->transportError(device);
+    }
+
+private:
+    QFile&                              m_file;
+    bool                                m_withChunks;
+    Listener*                           m_listener;
+    QHash<QString, QVector<quint32> >   m_chunks;
+};
+
+UsbCaptureTransport::UsbCaptureTransport(UsbTransport* transport, const QString& fileName)
+    : UsbTransport()
+    , m_transport(transport)
+    , m_file(fileName)
+    , m_chunks(true)
+{
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qCritical() << "Cannot open capture file" << fileName;
+        return;
+    }
+
+    if (m_file.size() == 0) {
+        m_file.write(USB_CAPTURE_MAGIC, USB_CAPTURE_MAGIC_LEN);
+    }
+    else {
+        QByteArray magic = m_file.read(USB_CAPTURE_MAGIC_LEN);
+        if (magic == QByteArray(USB_CAPTURE_MAGIC_V1, USB_CAPTURE_MAGIC_LEN)) {
+            qWarning() << "Capture file" << fileName << "of the previous version, the chunks are not recorded";
+            m_chunks = false;
+        }
+        else if (magic != QByteArray(USB_CAPTURE_MAGIC, USB_CAPTURE_MAGIC_LEN)) {
+            qCritical() << "Invalid capture file" << fileName;
+            m_file.close();
+            return;
+        }
+        m_file.seek(m_file.size());
+    }
+    qDebug() << "Capturing to" << fileName;
+}
+
+UsbCaptureTransport::~UsbCaptureTransport()
+{
+    if (m_file.isOpen())
+        m_file.close();
+    delete m_transport;
+}
+
+QString UsbCaptureTransport::getName() const
+{
+    return m_transport->getName() + " captured to " + m_file.fileName();
+}
+
+bool UsbCaptureTransport::download(const bool allDevices, const int queueDepth, Listener* listener)
+{
+    Recorder recorder(m_file, m_chunks, listener);
+    return m_transport->download(allDevices, queueDepth, &recorder);
+}
+
+bool UsbCaptureTransport::hasHotplug() const
+{
+    return m_transport->hasHotplug();
+}
+
+bool UsbCaptureTransport::waitForScales()
+{
+    return m_transport->waitForScales();
+}
+
+void UsbCaptureTransport::clearPending()
+{
+    m_transport->clearPending();
+}
+
+void UsbCaptureTransport::wakeUp()
+{
+    m_transport->wakeUp();
+}
+
+} // namespace Usb
+} // namespace BSM
@@ -0,0 +1,95 @@
+/*!
+ * \file UsbCaptureTransport.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbCaptureTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBCAPTURETRANSPORT_HPP
+#define USBCAPTURETRANSPORT_HPP
+
+#include <Usb/UsbTransport.hpp>
+
+#include <QtCore/QFile>
+
+//! Magic bytes at the start of a capture file
+#define USB_CAPTURE_MAGIC       "BSMCAP02"
+//! Magic bytes of the capture files without the chunks
+#define USB_CAPTURE_MAGIC_V1    "BSMCAP01"
+//! Size in byte of the magic bytes
+#define USB_CAPTURE_MAGIC_LEN   8
+//! Size in byte of the header of each record
+#define USB_CAPTURE_HEADER_LEN  16
+//! Maximum number of chunks of a record
+#define USB_CAPTURE_MAX_CHUNKS  0xFFFF
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \class BSM::Usb::UsbCaptureTransport
+ * \brief Transport that records the data downloaded by another transport.
+ *
+ * Each completed download is appended to a binary capture file, that can be
+ * played back by UsbReplayTransport. Together with the memory image, the record
+ * keeps the sizes of the data received by each event of the download, so the
+ * replay delivers the data in the same chunks.
+ *
+ * The file starts with the 8 magic bytes \c BSMCAP02, followed by the records.
+ * Each record has a 16 bytes header, with all the values in little-endian:
+ * - 8 bytes: the time of the download, in ms since the epoch
+ * - 4 bytes: the size of the data
+ * - 2 bytes: the size of the scale identifier
+ * - 2 bytes: the number of chunks
+ *
+ * The header is followed by the scale identifier (UTF-8), by the sizes of the
+ * data received up to the end of each chunk (4 bytes each) and by the data.
+ *
+ * The files of the previous version, with the magic bytes \c BSMCAP01, have
+ * no chunks: the records appended to them are written without the chunks.
+ */
+class UsbCaptureTransport : public UsbTransport
+{
+public:
+    /*! Constructor of the class.
+     * \param transport the transport to record, owned by this object
+     * \param fileName the capture file, the records are appended
+     */
+    UsbCaptureTransport(UsbTransport* transport, const QString& fileName);
+    virtual ~UsbCaptureTransport();
+
+    virtual QString getName() const;
+    virtual bool download(const bool allDevices, const int queueDepth, Listener* listener);
+    virtual bool hasHotplug() const;
+    virtual bool waitForScales();
+    virtual void clearPending();
+    virtual void wakeUp();
+
+private:
+    class Recorder;
+
+    UsbTransport*   m_transport;
+    QFile           m_file;
+    bool            m_chunks;
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBCAPTURETRANSPORT_HPP
@@ -29,74 +29,27 @@
 namespace BSM {
 namespace Usb {
 
-//! Number of users in the scale memory.
-#define NUM_USERS        10
-//! Number of variables saved for each user.
-#define NUM_USER_VARS     6
-//! Number of samples in each variable
-#define NUM_SAMPLES      60
-//! Size in byte of each sample.
-#define SAMPLE_LEN        2
-//! Size in byte of the variables separator (all with value 0)
-#define SEPARATOR_LEN     8
-
-//! Size in byte of a variable
-#define VAR_LEN         (NUM_SAMPLES * SAMPLE_LEN + SEPARATOR_LEN)
-//! Size in byte of an user block
-#define USER_LEN        (NUM_USER_VARS * VAR_LEN)
-//! Size in byte of the last block.
-#define EXTRA_BLOCK_LEN 512
-//! Size in byte of the offset in the last block.
-#define EXTRA_BLOCK_OFF (NUM_USERS * USER_LEN + 256)
-//! Size in byte of each user block in the extra block
-#define EXTRA_USER_LEN    8
-//! Size in byte of the offset in the ptr block
-#define PTR_BLOCK_OFF   (EXTRA_BLOCK_OFF + NUM_USERS * EXTRA_USER_LEN + 16)
-
-//! Size in byte of the offset of the scale date
-#define SCALE_DATE_OFF  (NUM_USERS * USER_LEN + 480)
-//! Size in byte of the offset of the scale time
-#define SCALE_TIME_OFF  (NUM_USERS * USER_LEN + 483)
-
-//! Expected length in byte for all data.
-#define EXPECTED_LEN    (NUM_USERS * USER_LEN + EXTRA_BLOCK_LEN)
-
-/*! Convert two bytes to a unsigned short.
- * \param b1 the higher byte
- * \param b2 the lower byte
- * \return the unsigned short
- */
-ushort uchar2ushort(const uchar b1, const uchar b2);
-
-/*! Convert an unsigned short to a QDate.
+/*! Convert a scale date word to a QDate.
  *
  * The conversion is done using the first 7 bit for the year (starting from the
  * 1920), 4 bits for the month and 5 bits for the day.
  *
- * \param b1 the higher byte
- * \param b2 the lower byte
- * \return the date, or a \c null QDate if invalid
- */
-QDate uchar2QDate(const uchar b1, const uchar b2);
-
-/*! Convert an unsigned short to a QTime
- *
- * The conversion is done using the higher byte for the hours and the lower byte
- * for the minutes.
- *
- * \param b1 the higher byte
- * \param b2 the lower byte
+ * \param word the date word
  * \return the date, or a \c null QDate if invalid
  */
-QTime uchar2QTime(const uchar b1, const uchar b2);
+QDate word2QDate(const quint16 word);
 
 UsbData::UsbData(QObject* parent)
     : QObject(parent)
+    , m_parser(&m_scaleData)
 {
+    m_buffer.reserve(m_parser.imageSize());
+    clearCursors();
 }
 
 UsbData::~UsbData()
 {
+    qDeleteAll(m_userData);
 }
 
 QDateTime UsbData::getDateTime() const
@@ -109,87 +62,132 @@ Data::UserDataList& UsbData::getUserData()
     return m_userData;
 }
 
+bool UsbData::isCompleted() const
+{
+    return m_parser.isCompleted();
+}
+
+const UsbScaleData& UsbData::getScaleData() const
+{
+    return m_scaleData;
+}
+
+quint64 UsbData::imageHash(const QByteArray& data) const
+{
+    return m_parser.getModel()->hash((const uchar*) data.constData(), data.size());
+}
+
+void UsbData::setModel(const UsbScaleModel* model)
+{
+    reset();
+    m_parser.setModel(model);
+}
+
+void UsbData::setCursor(const uchar id, const Data::SampleCursor& cursor)
+{
+    if (id < 1 || id > USB_MAX_USERS)
+        return;
+
+    m_cursors[id - 1] = cursor;
+    m_parser.setCursors(m_cursors);
+}
+
+void UsbData::clearCursors()
+{
+    for (int i = 0; i < USB_MAX_USERS; ++i) {
+        m_cursors[i].timestamp = Data::Timestamp::Invalid;
+        m_cursors[i].count = 0;
+        m_cursors[i].pointer = 0;
+    }
+    m_parser.setCursors(0);
+}
+
+void UsbData::setPrevious(const QByteArray& previous)
+{
+    if (!previous.isNull() && previous.size() != m_parser.imageSize()) {
+        qWarning() << "Wrong size of the previous image:" << previous.size() << "bytes";
+        m_previous = QByteArray();
+    }
+    else
+        m_previous = previous;
+    m_parser.setPrevious(m_previous.isNull() ? 0 : (const uchar*) m_previous.constData());
+}
+
 bool UsbData::parse(const QByteArray& data)
 {
-    if (data.size() != EXPECTED_LEN)
+    if (data.size() != m_parser.imageSize())
         return false;
 
-    QDate scale_date = uchar2QDate(data[SCALE_DATE_OFF], data[SCALE_DATE_OFF + 1]);
-    QTime scale_time = uchar2QTime(data[SCALE_TIME_OFF], data[SCALE_TIME_OFF + 1]);
-    m_dateTime = QDateTime(scale_date, scale_time);
+    reset();
+    feed(data);
+    return isCompleted();
+}
+
+void UsbData::reset()
+{
+    m_dateTime = QDateTime();
 
     qDeleteAll(m_userData);
     m_userData.clear();
 
-    for (int user = 0; user < NUM_USERS; ++user) {
-        int user_offset = user * USER_LEN;
-        int extra_offset = EXTRA_BLOCK_OFF + user * EXTRA_USER_LEN;
+    m_parser.reset();
+    m_buffer.clear();
+}
 
-        uchar id = data[extra_offset];
-        if (id < 1 || id > 10)
-            continue;
+bool UsbData::feed(const QByteArray& chunk)
+{
+    if (m_buffer.size() + chunk.size() > m_parser.imageSize()) {
+        qWarning() << "Too many data received:" << m_buffer.size() + chunk.size() << "bytes";
+        return false;
+    }
+    m_buffer.append(chunk);
 
-        Data::UserData* ud = new Data::UserData();
-        ud->setId(id);
-        ud->setHeight(data[extra_offset + 1]);
-        ud->setBirthDate(uchar2QDate(data[extra_offset + 2], data[extra_offset + 3]));
-        ud->setGender( ((data[extra_offset + 4] & 0x80) == 0x00) ? Data::UserData::Male : Data::UserData::Female );
-        switch (data[extra_offset + 4] & 0x0F) {
-            case 0:
-                ud->setActivity(Data::UserData::None);
-                break;
-            case 1:
-                ud->setActivity(Data::UserData::Low);
-                break;
-            case 2:
-                ud->setActivity(Data::UserData::Medium);
-                break;
-            case 3:
-                ud->setActivity(Data::UserData::High);
-                break;
-            case 4:
-                ud->setActivity(Data::UserData::VeryHigh);
-                break;
-            default:
-                // Invalid value, set to None
-                ud->setActivity(Data::UserData::None);
-                break;
-        }
+    int stages = m_parser.feed((const uchar*) m_buffer.constData(), m_buffer.size());
 
-        uchar num_samples = data[extra_offset + 5];
-        uchar ptr_samples = data[PTR_BLOCK_OFF + user];
-
-        for (int sample = 0; sample < NUM_SAMPLES && sample < num_samples; ++sample) {
-            int sample_offset = sample;
-            if (num_samples == NUM_SAMPLES)
-                sample_offset = (sample + ptr_samples) % NUM_SAMPLES;
-            int weight_offset  = user_offset + 0 * VAR_LEN + sample_offset * SAMPLE_LEN;
-            int bodyFat_offset = user_offset + 1 * VAR_LEN + sample_offset * SAMPLE_LEN;
-            int water_offset   = user_offset + 2 * VAR_LEN + sample_offset * SAMPLE_LEN;
-            int muscle_offset  = user_offset + 3 * VAR_LEN + sample_offset * SAMPLE_LEN;
-            int date_offset    = user_offset + 4 * VAR_LEN + sample_offset * SAMPLE_LEN;
-            int time_offset    = user_offset + 5 * VAR_LEN + sample_offset * SAMPLE_LEN;
-
-            QDate date = uchar2QDate(data[date_offset], data[date_offset + 1]);
-            QTime time = uchar2QTime(data[time_offset], data[time_offset + 1]);
-            QDateTime dateTime = QDateTime(date, time);
-            if (dateTime.isNull() || !dateTime.isValid())
-                break;
+    if (stages & UsbScaleParser::Users)
+        buildUsers();
 
+    if (stages & UsbScaleParser::Completed) {
+        m_dateTime = Data::Timestamp(m_scaleData.dateTime).toDateTime();
+        emit parsed();
+    }
+
+    return true;
+}
+
+void UsbData::buildUsers()
+{
+    for (int user = 0; user < USB_MAX_USERS; ++user) {
+        const UsbUserSamples& samples = m_scaleData.users[user];
+        if (samples.id == 0)
+            continue;
+
+        Data::UserData* ud = new Data::UserData();
+        ud->setId(samples.id);
+        ud->setHeight(samples.height);
+        ud->setBirthDate(word2QDate(samples.birthDate));
+        ud->setGender(samples.female ? Data::UserData::Female : Data::UserData::Male);
+        ud->setActivity(Data::UserData::Activity(Data::UserData::None + samples.activity));
+        ud->setCursor(samples.cursor);
+
+        // The samples are in the order they were taken, but the clock of the scale
+        // can be set back: sort them by timestamp for UserData::getMeasurementRange()
+        Data::UserMeasurementList measurements;
+        for (int sample = 0; sample < samples.numSamples; ++sample) {
             Data::UserMeasurement* um = new Data::UserMeasurement();
-            um->setWeight(uchar2ushort(data[weight_offset], data[weight_offset + 1]) * 0.1);
-            um->setBodyFatPercent(uchar2ushort(data[bodyFat_offset], data[bodyFat_offset + 1]) * 0.1);
-            um->setWaterPercent(uchar2ushort(data[water_offset], data[water_offset + 1]) * 0.1);
-            um->setMusclePercent(uchar2ushort(data[muscle_offset], data[muscle_offset + 1]) * 0.1);
-            um->setDateTime(dateTime);
+            um->setWeight(samples.weight[sample] * 0.1);
+            um->setBodyFatPercent(samples.bodyFat[sample] * 0.1);
+            um->setWaterPercent(samples.water[sample] * 0.1);
+            um->setMusclePercent(samples.muscle[sample] * 0.1);
+            um->setTimestamp(Data::Timestamp(samples.timestamp[sample]));
 
-            ud->getMeasurements().append(um);
+            measurements.append(um);
         }
+        ud->setMeasurements(measurements);
 
         m_userData.append(ud);
+        emit userParsed(ud);
     }
-
-    return true;
 }
 
 QDebug operator<<(QDebug dbg, const UsbData& ud)
@@ -216,27 +214,12 @@ QDebug operator<<(QDebug dbg, const UsbData* ud)
 #endif
 }
 
-ushort uchar2ushort(const uchar b1, const uchar b2)
-{
-    ushort word = b1;
-    word = (word << 8) + b2;
-    return word;
-}
-
-QDate uchar2QDate(const uchar b1, const uchar b2)
+QDate word2QDate(const quint16 word)
 {
-    ushort word = uchar2ushort(b1, b2);
     if (word == 0 || word == 0xFFFF)
         return QDate();
     return QDate(1920 + (word >> 9), (word >> 5) & 0xF, word & 0x1F);
 }
 
-QTime uchar2QTime(const uchar b1, const uchar b2)
-{
-    if (b1 > 23 || b2 > 59)
-        return QTime();
-    return QTime(b1, b2);
-}
-
 } // namespace Usb
 } // namespace BSM
@@ -30,6 +30,7 @@
 #include <QtCore/QByteArray>
 
 #include <Data/UserData.hpp>
+#include <Usb/UsbScaleData.hpp>
 
 namespace BSM {
 namespace Usb {
@@ -42,6 +43,15 @@ namespace Usb {
  * Some received data are note decoded ore used: for now only users measurements,
  * user parameters (birth date, height, gender and degree of activity) and
  * current date and time from the scale are decoded.
+ *
+ * The data can be parsed at once with parse() or fed while they are downloaded
+ * with feed(): the measurements of each user are decoded as soon as the block
+ * of the user is received, the users are built when the pointer block is
+ * received (userParsed() is emitted for each one) and the parsing is completed
+ * with the date and time of the scale (parsed() is emitted).
+ *
+ * The data are decoded by a UsbScaleParser into a UsbScaleData, available
+ * with getScaleData(); this class is the QObject view of it for the GUI.
  */
 class UsbData : public QObject
 {
@@ -79,6 +89,53 @@ public:
      */
     Data::UserDataList& getUserData();
 
+    /*! Check if all the data were parsed.
+     * \return \c true if the users and the date and time of the scale are available, \c false otherwise
+     */
+    bool isCompleted() const;
+
+    /*! Get the decoded data, without the QObject view.
+     *
+     * The data are valid only when isCompleted() returns \c true.
+     */
+    const UsbScaleData& getScaleData() const;
+
+    /*! Hash the content of a memory image of the scale.
+     *
+     * The date and the time of the scale are not hashed: the hash changes only
+     * if a user was added, changed or weighed.
+     * \param data the memory image of the scale
+     * \return the hash of the image
+     * \sa UsbScaleModel::hash
+     */
+    quint64 imageHash(const QByteArray& data) const;
+
+    /*! Set the model of the scale, the parsed data are discarded.
+     * \param model the model of the scale, \c 0 for the BF 480 USB
+     * \sa UsbScaleModel::find
+     */
+    void setModel(const UsbScaleModel* model);
+
+    /*! Set the cursor of a user at the last download.
+     *
+     * The samples of the user written before the cursor are not decoded.
+     * \param id the ID of the user
+     * \param cursor the cursor saved at the last download
+     * \sa Data::UserData::getCursor
+     */
+    void setCursor(const uchar id, const Data::SampleCursor& cursor);
+
+    //! Forget the cursors, all the samples are decoded.
+    void clearCursors();
+
+    /*! Set the image of the last download of the scale.
+     *
+     * Only the users changed since that image are parsed and built.
+     * \param previous the image, a \c null QByteArray to parse all the users
+     * \sa UsbScaleParser::setPrevious
+     */
+    void setPrevious(const QByteArray& previous);
+
 public slots:
     /*! \brief Parse the USB data.
      *
@@ -89,10 +146,41 @@ public slots:
      */
     bool parse(const QByteArray& data);
 
+    //! Discard the parsed data and get ready for a new feed.
+    void reset();
+
+    /*! \brief Parse the next chunk of the USB data.
+     *
+     * The chunk is appended to the data received so far and everything that
+     * can be decoded with it is parsed.
+     * \param chunk the new data received from the scale
+     * \return \c true if the chunk was accepted, \c false if it exceeds the expected size
+     * \sa reset isCompleted
+     */
+    bool feed(const QByteArray& chunk);
+
+signals:
+    /*! A user was parsed.
+     * \param user the user, owned by this object
+     */
+    void userParsed(BSM::Data::UserData* user);
+
+    //! All the data were parsed.
+    void parsed();
+
 private:
+    //! Build the users from the decoded data.
+    void buildUsers();
+
     QDateTime           m_dateTime;
     Data::UserDataList  m_userData;
 
+    UsbScaleData        m_scaleData;    // The decoded data
+    UsbScaleParser      m_parser;       // The decoder of the data
+    Data::SampleCursor  m_cursors[USB_MAX_USERS];   // The cursors of the last download by user ID
+    QByteArray          m_buffer;       // The data received so far
+    QByteArray          m_previous;     // The image of the last download
+
     friend QDebug operator<<(QDebug dbg, const UsbData& ud);
 };
 
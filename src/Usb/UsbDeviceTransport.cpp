@@ -0,0 +1,324 @@
+/*!
+ * \file UsbDeviceTransport.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbDeviceTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbDeviceTransport.hpp"
+#include "UsbSession.hpp"
+#include "UsbScaleData.hpp"
+
+#include <QtCore/QDebug>
+#include <QtCore/QVector>
+
+namespace BSM {
+namespace Usb {
+
+//! Delay in ms between the plug in of a scale and the start of the download
+#define USB_HOTPLUG_DELAY   1500
+
+UsbDeviceTransport::UsbDeviceTransport()
+    : UsbTransport()
+    , m_ctx(0)
+    , m_hotplugRegistered(false)
+{
+    m_hotplugState.pending = false;
+    m_hotplugState.deadline = 0;
+    m_hotplugState.clock.start();
+
+    // Initialize libusb session
+    if (libusb_init(&m_ctx) < 0) {
+        qCritical() << "Failed to initialize libusb";
+        m_ctx = 0;
+        return;
+    }
+
+    // Set debug-level to INFO
+    libusb_set_debug(m_ctx, LIBUSB_LOG_LEVEL_INFO);
+    qDebug() << "libusb initialized";
+}
+
+UsbDeviceTransport::~UsbDeviceTransport()
+{
+    // Close the sessions before the libusb context
+    qDeleteAll(m_sessions);
+    m_sessions.clear();
+
+    if (m_ctx) {
+        if (m_hotplugRegistered)
+            libusb_hotplug_deregister_callback(m_ctx, m_hotplug);
+        foreach (libusb_device* dev, m_hotplugState.arrived + m_hotplugState.ready + m_hotplugState.left)
+            libusb_unref_device(dev);
+
+        // Close libusb session
+        libusb_exit(m_ctx);
+        qDebug() << "libusb closed";
+    }
+}
+
+QString UsbDeviceTransport::getName() const
+{
+    return "libusb";
+}
+
+bool UsbDeviceTransport::download(const bool allDevices, const int queueDepth, Listener* listener)
+{
+    if (!m_ctx) {
+        qCritical() << "Missing initialization for libusb";
+        return false;
+    }
+
+    // After a hotplug event only the scales plugged in are downloaded
+    QList<libusb_device*> targets = m_hotplugState.ready;
+    m_hotplugState.ready.clear();
+
+    libusb_device** list = 0;
+    ssize_t count = libusb_get_device_list(m_ctx, &list);
+    if (count < 0) {
+        qCritical() << "libusb_get_device_list error" << count;
+        foreach (libusb_device* dev, targets)
+            libusb_unref_device(dev);
+        return false;
+    }
+
+    // Close the sessions of the scales no longer connected
+    foreach (UsbSession* session, m_sessions) {
+        bool found = false;
+        for (ssize_t i = 0; i < count && !found; ++i)
+            found = (list[i] == session->getDevice());
+        if (!found)
+            closeSession(session->getDevice());
+    }
+
+    // Open USB devices, or reuse the sessions already open
+    QList<UsbSession*> sessions;
+    for (ssize_t i = 0; i < count; ++i) {
+        libusb_device_descriptor desc;
+        if (libusb_get_device_descriptor(list[i], &desc) < 0)
+            continue;
+        if (!UsbScaleModel::find(desc.idVendor, desc.idProduct))
+            continue;
+        if (!targets.isEmpty() && !targets.contains(list[i]))
+            continue;
+
+        UsbSession* session = findSession(list[i]);
+        if (session) {
+            qDebug() << "Reusing session for" << session->getId();
+        }
+        else {
+            session = new UsbSession(m_ctx, list[i]);
+            if (!session->open()) {
+                listener->transportError(session->getId());
+                delete session;
+                continue;
+            }
+            m_sessions.append(session);
+        }
+        sessions.append(session);
+        if (!allDevices)
+            break;
+    }
+    libusb_free_device_list(list, 1);
+    foreach (libusb_device* dev, targets)
+        libusb_unref_device(dev);
+
+    if (sessions.isEmpty()) {
+        qCritical() << "Failed to open the device";
+        return false;
+    }
+
+    // Start all the downloads
+    bool success = false;
+    QVector<bool> reported(sessions.size(), false);
+    QVector<int> lastSize(sessions.size(), 0);
+    int running = 0;
+    for (int i = 0; i < sessions.size(); ++i) {
+        listener->transportStarted(sessions[i]->getId());
+        if (sessions[i]->start(queueDepth)) {
+            ++running;
+        }
+        else {
+            reported[i] = true;
+            listener->transportError(sessions[i]->getId());
+        }
+    }
+
+    // Wait for completion of all the devices
+    while (running > 0) {
+        int r = libusb_handle_events_completed(m_ctx, 0);
+
+        for (int i = 0; i < sessions.size(); ++i) {
+            UsbSession* session = sessions[i];
+            if (reported[i])
+                continue;
+
+            if (session->getSize() != lastSize[i]) {
+                lastSize[i] = session->getSize();
+                listener->transportReceived(session->getId(), session->getData(), session->getSize());
+            }
+
+            if (session->isCompleted()) {
+                reported[i] = true;
+                --running;
+                qDebug() << "Downloaded" << session->getId() << "in" << session->getElapsed() << "ms with" << queueDepth << "transfers in flight";
+#ifndef QT_NO_DEBUG_OUTPUT
+                session->dumpTrace();
+#endif
+                listener->transportCompleted(session->getId(), session->getData(), session->getSize());
+                success = true;
+            }
+            else if (session->isFailed() || r < 0) {
+                reported[i] = true;
+                --running;
+#ifndef QT_NO_DEBUG_OUTPUT
+                session->dumpTrace();
+#endif
+                listener->transportError(session->getId());
+            }
+        }
+    }
+
+    // Stop the transfers still in flight, the sessions of the failed scales are closed
+    foreach (UsbSession* session, sessions) {
+        session->cancel();
+        if (!session->isCompleted())
+            closeSession(session->getDevice());
+    }
+
+    return success;
+}
+
+bool UsbDeviceTransport::hasHotplug() const
+{
+    return m_ctx && libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG);
+}
+
+bool UsbDeviceTransport::waitForScales()
+{
+    if (!hasHotplug())
+        return false;
+
+    // Register for the scales, the ones already connected are reported too
+    if (!m_hotplugRegistered) {
+        int r = libusb_hotplug_register_callback(m_ctx,
+                                                 (libusb_hotplug_event) (LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED | LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT),
+                                                 LIBUSB_HOTPLUG_ENUMERATE, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY, LIBUSB_HOTPLUG_MATCH_ANY,
+                                                 cb_hotplug, this, &m_hotplug);
+        if (r != LIBUSB_SUCCESS) {
+            qCritical() << "libusb_hotplug_register_callback error" << r;
+            return false;
+        }
+        m_hotplugRegistered = true;
+        qDebug() << "Waiting for scales";
+    }
+
+    // Close the sessions of the scales unplugged
+    while (!m_hotplugState.left.isEmpty()) {
+        libusb_device* dev = m_hotplugState.left.takeFirst();
+        closeSession(dev);
+        libusb_unref_device(dev);
+    }
+
+    if (!m_hotplugState.pending) {
+        // Sleep until something happens on the bus
+        libusb_handle_events_completed(m_ctx, 0);
+        return false;
+    }
+
+    // Wait for the enumeration of the scale to settle
+    qint64 wait = m_hotplugState.deadline - m_hotplugState.clock.elapsed();
+    if (wait <= 0) {
+        m_hotplugState.pending = false;
+        m_hotplugState.ready += m_hotplugState.arrived;
+        m_hotplugState.arrived.clear();
+        return true;
+    }
+    timeval tv;
+    tv.tv_sec = wait / 1000;
+    tv.tv_usec = (wait % 1000) * 1000;
+    libusb_handle_events_timeout_completed(m_ctx, &tv, 0);
+    return false;
+}
+
+void UsbDeviceTransport::clearPending()
+{
+    m_hotplugState.pending = false;
+    foreach (libusb_device* dev, m_hotplugState.arrived)
+        libusb_unref_device(dev);
+    m_hotplugState.arrived.clear();
+}
+
+void UsbDeviceTransport::wakeUp()
+{
+    if (m_ctx)
+        libusb_interrupt_event_handler(m_ctx);
+}
+
+UsbSession* UsbDeviceTransport::findSession(libusb_device* dev) const
+{
+    foreach (UsbSession* session, m_sessions) {
+        if (session->getDevice() == dev)
+            return session;
+    }
+    return 0;
+}
+
+void UsbDeviceTransport::closeSession(libusb_device* dev)
+{
+    UsbSession* session = findSession(dev);
+    if (!session)
+        return;
+
+    m_sessions.removeAll(session);
+    delete session;
+}
+
+int UsbDeviceTransport::cb_hotplug(libusb_context* ctx, libusb_device* dev, libusb_hotplug_event event, void* user_data)
+{
+    HotplugState* state = &((UsbDeviceTransport*) user_data)->m_hotplugState;
+
+    // All the devices are reported, keep only the supported scales
+    libusb_device_descriptor desc;
+    if (libusb_get_device_descriptor(dev, &desc) < 0 || !UsbScaleModel::find(desc.idVendor, desc.idProduct))
+        return 0;
+
+    if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED) {
+        qDebug() << "Scale plugged in" << UsbSession::deviceId(dev);
+        if (!state->arrived.contains(dev))
+            state->arrived.append(libusb_ref_device(dev));
+        // A re-enumerating scale arrives more than once: restart the delay
+        state->pending = true;
+        state->deadline = state->clock.elapsed() + USB_HOTPLUG_DELAY;
+    }
+    else if (event == LIBUSB_HOTPLUG_EVENT_DEVICE_LEFT) {
+        qDebug() << "Scale unplugged" << UsbSession::deviceId(dev);
+        if (state->arrived.removeOne(dev))
+            libusb_unref_device(dev);
+        if (state->arrived.isEmpty())
+            state->pending = false;
+        // The session can't be closed inside the callback
+        state->left.append(libusb_ref_device(dev));
+    }
+
+    return 0;
+}
+
+} // namespace Usb
+} // namespace BSM
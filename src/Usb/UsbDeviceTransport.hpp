@@ -0,0 +1,107 @@
+/*!
+ * \file UsbDeviceTransport.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbDeviceTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBDEVICETRANSPORT_HPP
+#define USBDEVICETRANSPORT_HPP
+
+#include <Usb/UsbTransport.hpp>
+
+#include <QtCore/QList>
+#include <QtCore/QElapsedTimer>
+
+#include <libusb.h>
+
+namespace BSM {
+namespace Usb {
+
+class UsbSession;
+
+/*!
+ * \class BSM::Usb::UsbDeviceTransport
+ * \brief Transport for the real scales, through libusb.
+ *
+ * All the scales are driven by the event loop of the same libusb context.
+ * The scales are kept open between downloads through a UsbSession; the session
+ * is closed when the scale is unplugged or the download fails.
+ *
+ * The hotplug support registers a libusb hotplug callback: a scale is ready
+ * when it was plugged in at least 1.5 seconds before, so a re-enumerating scale
+ * triggers only one download. That download is limited to the devices reported
+ * by the callback, the other scales connected are not downloaded again.
+ */
+class UsbDeviceTransport : public UsbTransport
+{
+public:
+    //! Constructor of the class.
+    UsbDeviceTransport();
+    virtual ~UsbDeviceTransport();
+
+    virtual QString getName() const;
+    virtual bool download(const bool allDevices, const int queueDepth, Listener* listener);
+    virtual bool hasHotplug() const;
+    virtual bool waitForScales();
+    virtual void clearPending();
+    virtual void wakeUp();
+
+private:
+    //! \private
+    struct HotplugState {
+        QElapsedTimer clock;
+        bool pending;
+        qint64 deadline;
+        QList<libusb_device*> arrived;
+        QList<libusb_device*> ready;
+        QList<libusb_device*> left;
+    };
+
+    /*! Callback for the USB hotplug events.
+     * \param ctx the libusb context
+     * \param dev the device plugged in or unplugged
+     * \param event the hotplug event
+     * \param user_data the pointer to the UsbDeviceTransport
+     * \return always \c 0, to keep the callback registered
+     */
+    static int cb_hotplug(libusb_context* ctx, libusb_device* dev, libusb_hotplug_event event, void* user_data);
+
+    /*! Find the open session of a scale.
+     * \param dev the libusb device of the scale
+     * \return the session, or \c 0 if the scale is not open
+     */
+    UsbSession* findSession(libusb_device* dev) const;
+
+    /*! Close the session of a scale, if open.
+     * \param dev the libusb device of the scale
+     */
+    void closeSession(libusb_device* dev);
+
+    libusb_context*                 m_ctx;
+    QList<UsbSession*>              m_sessions;
+    bool                            m_hotplugRegistered;
+    libusb_hotplug_callback_handle  m_hotplug;
+    HotplugState                    m_hotplugState;
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBDEVICETRANSPORT_HPP
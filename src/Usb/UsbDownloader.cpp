@@ -22,275 +22,250 @@
  */
 
 #include "UsbDownloader.hpp"
-
-#include <libusb.h>
+#include "UsbDeviceTransport.hpp"
+#include "UsbCaptureTransport.hpp"
+#include "UsbReplayTransport.hpp"
 
 #include <QtCore/QDebug>
+#include <QtCore/QMutexLocker>
 #include <QtCore/QFile>
+#include <QtCore/QElapsedTimer>
 
 namespace BSM {
 namespace Usb {
 
-//! USB Vendor ID for the Beurer USB Scale
-#define BSM_VID             0x04d9
-//! USB Product ID for the Beurer USB Scale (found on BF 480 USB model)
-#define BSM_PID             0x8010
-//! USB interface number for control transfer
-#define USB_INTERFACE_IN    0x00
-//! USB interface number for interrupt transfer
-#define USB_INTERFACE_OUT   0x01
-//! USB interrupt data length
-#define USB_INTR_DATA_LEN   8
-//! USB control bRequest - HID set report
-#define USB_CTRL_REQUEST    0x09
-//! USB control wValue
-#define USB_CTRL_VALUE      0x0300
-//! USB control data length
-#define USB_CTRL_DATA_LEN   8
-//! USB control data first byte value (others are 0x00)
-#define USB_CTRL_DATA_FIRST 0x10
-//! USB expected data length
-#define USB_EXPECTED_LEN    8192
-
-//! File to read to simulate USB data (debug)
-// #define USB_READ_DUMP       "usbdata.txt"
-//! File for the dump of the USB data (debug)
-// #define USB_WRITE_DUMP      "usbdump.txt"
-
-//! \private
-struct UsbDownloaderData {
-    bool completed;
-    QByteArray data;
-#ifdef USB_WRITE_DUMP
-    QFile dump;
-#endif
-};
+//! Default number of interrupt transfers in flight for each scale
+#define USB_QUEUE_DEPTH     8
 
-/*!
- * Callback for the USB control transfer.
- * \param transfer the pointer to the the control transfer
- */
-void cb_out(libusb_transfer *transfer);
-/*!
- * Callback for the USB interrupt transfer.
- * \param transfer the pointer to the the control transfer
- */
-void cb_in(libusb_transfer *transfer);
+//! Environment variable with the capture file to play back
+#define USB_REPLAY_ENV      "BSM_USB_REPLAY"
+//! Environment variable with the capture file to record
+#define USB_CAPTURE_ENV     "BSM_USB_CAPTURE"
 
 UsbDownloader::UsbDownloader(QObject* parent)
     : QThread(parent)
-    , ctx(0)
+    , m_transport(0)
+    , m_mode(FirstDevice)
+    , m_autoDownload(false)
+    , m_queueDepth(USB_QUEUE_DEPTH)
+    , m_downloadTime(-1)
+    , m_stop(0)
+    , m_requested(0)
+    , m_exiting(false)
+    , m_receivedTotal(0)
 {
-#ifndef USB_READ_DUMP
-    // Initialize libusb session
-    if (libusb_init(&ctx) < 0) {
-        qCritical() << "Failed to initialize libusb";
-        ctx = 0;
-        return;
-    }
-
-    // Set debug-level to INFO
-    libusb_set_debug(ctx, LIBUSB_LOG_LEVEL_INFO);
-    qDebug() << "libusb initialized";
-#endif
+    // Select the transport
+    QByteArray replay = qgetenv(USB_REPLAY_ENV);
+    if (!replay.isEmpty())
+        m_transport = new UsbReplayTransport(QFile::decodeName(replay));
+    else
+        m_transport = new UsbDeviceTransport();
+
+    QByteArray capture = qgetenv(USB_CAPTURE_ENV);
+    if (!capture.isEmpty())
+        m_transport = new UsbCaptureTransport(m_transport, QFile::decodeName(capture));
 }
 
 UsbDownloader::~UsbDownloader()
 {
-#ifndef USB_READ_DUMP
-    if (ctx) {
-        // Close libusb session
-        libusb_exit(ctx);
-        qDebug() << "libusb closed";
+    if (isRunning()) {
+        stopAutoDownload();
+        wait();
     }
-#endif
+
+    delete m_transport;
 }
 
-void UsbDownloader::run()
+void UsbDownloader::setTransport(UsbTransport* transport)
 {
-    bool hasError = true;
-#ifndef USB_READ_DUMP
-    libusb_device_handle* handle = 0;
+    delete m_transport;
+    m_transport = transport;
+}
 
-    do { // Error loop
-        int r;
+UsbDownloader::Mode UsbDownloader::getMode() const
+{
+    return m_mode;
+}
 
-        if (!ctx) {
-            qCritical() << "Missing initialization for libusb";
-            break;
-        }
+void UsbDownloader::setMode(const UsbDownloader::Mode& mode)
+{
+    m_mode = mode;
+}
 
-        // Open USB device
-        handle = libusb_open_device_with_vid_pid(ctx, BSM_VID, BSM_PID);
-        if (!handle) {
-            qCritical() << "Failed to open the device";
-            break;
-        }
-        qDebug() << "USB device opened";
-
-        // Detach kernel driver
-        if (libusb_kernel_driver_active(handle, USB_INTERFACE_IN)) {
-            qDebug() << "Detaching kernel driver...";
-            r = libusb_detach_kernel_driver(handle, USB_INTERFACE_IN);
-            if (r < 0) {
-                qCritical() << "libusb_detach_kernel_driver error" << r;
-                break;
-            }
-            qDebug() << "Kernel driver detached";
-        }
+bool UsbDownloader::getAutoDownload() const
+{
+    return m_autoDownload;
+}
 
-        // Claim interface
-        qDebug() << "Claiming interface...";
-        r = libusb_claim_interface(handle, USB_INTERFACE_IN);
-        if (r < 0) {
-            qCritical() << "usb_claim_interface error" << r;
-            break;
-        }
-        qDebug() << "Interface claimed";
-
-        // Prepare to receive data
-        qDebug() << "Register for interrupt data";
-        libusb_transfer *transfer_receive = libusb_alloc_transfer(0);
-        unsigned char buffer_receive[8];
-        UsbDownloaderData usb_data;
-#ifdef USB_WRITE_DUMP
-        usb_data.dump.setFileName(USB_WRITE_DUMP);
-        usb_data.dump.open(QIODevice::WriteOnly | QIODevice::Truncate);
-#endif
-        libusb_fill_interrupt_transfer(transfer_receive, handle, LIBUSB_ENDPOINT_IN | USB_INTERFACE_OUT, buffer_receive, sizeof(buffer_receive), cb_in, &usb_data, 30000);
-        libusb_submit_transfer(transfer_receive);
-
-        // Prepare to send request
-        qDebug() << "Send control request";
-        libusb_transfer *transfer_send = libusb_alloc_transfer(0);
-        unsigned char buffer_send[LIBUSB_CONTROL_SETUP_SIZE + USB_CTRL_DATA_LEN] __attribute__ ((aligned (2)));
-        libusb_fill_control_setup(buffer_send, LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE, USB_CTRL_REQUEST, USB_CTRL_VALUE, 0, USB_CTRL_DATA_LEN);
-        buffer_send[LIBUSB_CONTROL_SETUP_SIZE] = USB_CTRL_DATA_FIRST;
-        memset(buffer_send + LIBUSB_CONTROL_SETUP_SIZE + 1, 0, USB_CTRL_DATA_LEN - 1);
-        libusb_fill_control_transfer(transfer_send, handle, buffer_send, cb_out, 0, 3000);
-        libusb_submit_transfer(transfer_send);
-
-        // Wait for completion
-        while (!usb_data.completed) {
-            qDebug() << "Waiting!";
-            r = libusb_handle_events_completed(ctx, 0);
-            emit progress(100 * usb_data.data.size() / USB_EXPECTED_LEN);
-            if (r < 0)
-                break;
-        }
+void UsbDownloader::setAutoDownload(const bool& autoDownload)
+{
+    m_autoDownload = autoDownload;
+    m_stop = 0;
+}
+
+int UsbDownloader::getQueueDepth() const
+{
+    return m_queueDepth;
+}
+
+void UsbDownloader::setQueueDepth(const int& queueDepth)
+{
+    m_queueDepth = qBound(1, queueDepth, USB_MAX_QUEUE_DEPTH);
+}
+
+qint64 UsbDownloader::getDownloadTime() const
+{
+    return m_downloadTime;
+}
+
+void UsbDownloader::requestDownload()
+{
+    QMutexLocker locker(&m_mutex);
+    m_requested = 1;
+    if (isRunning() && !m_exiting) {
+        // The thread checks the request before exiting
+        m_transport->wakeUp();
+        return;
+    }
+    locker.unlock();
+
+    // The thread is exiting without seeing the request: start it again
+    wait();
+    m_exiting = false;
+    start();
+}
 
-#ifdef USB_WRITE_DUMP
-        if (usb_data.dump.isOpen())
-            usb_data.dump.close();
-#endif
+void UsbDownloader::stopAutoDownload()
+{
+    QMutexLocker locker(&m_mutex);
+    m_stop = 1;
+    m_transport->wakeUp();
+}
 
-        // Emit completion signal
-        if (usb_data.completed) {
-            emit completed(usb_data.data);
-            hasError = false;
+void UsbDownloader::run()
+{
+    QMutexLocker locker(&m_mutex);
+    m_exiting = false;
+    if (m_autoDownload && !m_stop) {
+        if (m_transport->hasHotplug()) {
+            locker.unlock();
+            monitor();
+            return;
         }
-    } while(false);
-
-    // Close USB device
-    if (handle) {
-        libusb_release_interface(handle, USB_INTERFACE_IN);
-        qDebug() << "Released interface";
-        libusb_close(handle);
-        handle = 0;
-        qDebug() << "Closed USB device";
+        qWarning() << "Hotplug not supported by the" << m_transport->getName() << ", automatic download disabled";
     }
-#else
-    do { // Error loop
-        QFile usb_data_file(USB_READ_DUMP);
-        if (!usb_data_file.open(QIODevice::ReadOnly | QIODevice::Text)) {
-            qCritical() << "Failed to open" << USB_READ_DUMP;
-            break;
+
+    // The requests received while downloading are served by this thread
+    forever {
+        m_requested = 0;
+        locker.unlock();
+        download();
+        locker.relock();
+        if (!m_requested || m_stop) {
+            m_exiting = true;
+            return;
         }
+    }
+}
 
-        UsbDownloaderData usb_data;
-#ifdef USB_WRITE_DUMP
-        usb_data.dump.setFileName(USB_WRITE_DUMP);
-        usb_data.dump.open(QIODevice::WriteOnly | QIODevice::Truncate);
-#endif
-
-        while (!usb_data_file.atEnd()) {
-            char buff[20];
-            qint64 s = usb_data_file.readLine(buff, 20);
-            if (s < 16 || s > 17)
-                break;
-
-            if (s == 17 && buff[16] != '\n')
-                break;
-
-            libusb_transfer t;
-            unsigned char b[8];
-            bool ok;
-            t.buffer = b;
-            t.actual_length = 8;
-            t.status = LIBUSB_TRANSFER_ERROR; // ignored as error, to avoid resubmit
-            t.user_data = &usb_data;
-            for(int i = 0; i < 8; ++i) {
-                b[i] = (unsigned char) QString("%1%2").arg(buff[i * 2]).arg(buff[i * 2 + 1]).toUShort(&ok, 16);
-                if (!ok)
-                    break;
-            }
-            if (!ok)
-                break;
-
-            cb_in(&t);
-            emit progress(100 * usb_data.data.size() / USB_EXPECTED_LEN);
+void UsbDownloader::monitor()
+{
+    QMutexLocker locker(&m_mutex);
+    while (!m_stop) {
+        if (m_requested) {
+            m_requested = 0;
+            locker.unlock();
+            download();
+            // The scales plugged in are downloaded too, no need to do it again
+            m_transport->clearPending();
+            locker.relock();
+            continue;
         }
 
-#ifdef USB_WRITE_DUMP
-        if (usb_data.dump.isOpen())
-            usb_data.dump.close();
-#endif
+        locker.unlock();
+        if (m_transport->waitForScales())
+            download();
+        locker.relock();
+    }
+    m_exiting = true;
+    qDebug() << "Stopped waiting for scales";
+}
+
+void UsbDownloader::download()
+{
+    emit downloadStarted();
 
-        if (usb_data_file.atEnd()) {
-            emit completed(usb_data.data);
-            hasError = false;
-        }
+    m_received.clear();
+    m_receivedTotal = 0;
+    m_progress.clear();
+    m_emitted.clear();
+
+    qDebug() << "Download through" << m_transport->getName();
+    QElapsedTimer clock;
+    clock.start();
+    bool success = m_transport->download(m_mode == AllDevices, m_queueDepth, this);
+    m_downloadTime = success ? clock.elapsed() : -1;
+    qDebug() << "Download time" << clock.elapsed() << "ms";
 
-        usb_data_file.close();
-    } while(false);
-#endif
     // Emit error signal
-    if (hasError)
+    if (!success)
         emit error();
+
+    emit downloadFinished();
 }
 
-void cb_out(struct libusb_transfer *transfer)
+void UsbDownloader::transportStarted(const QString& device)
 {
-    qDebug() << "[OUT]" << "status =" << transfer->status << "- actual length =" << transfer->actual_length;
+    m_received.insert(device, 0);
+    m_progress.insert(device, -1);
+    m_emitted.insert(device, 0);
 }
 
-void cb_in(struct libusb_transfer *transfer)
+void UsbDownloader::transportReceived(const QString& device, const unsigned char* data, const int size)
 {
-    qDebug() << "[IN]" << "status =" << transfer->status << "- actual length =" << transfer->actual_length;
-    QString s;
-    for (int i = 0; i < transfer->actual_length; ++i) {
-        s.append(QString("%1 ").arg((short) transfer->buffer[i], 2, 16, QChar('0')));
+    int received = qMin(size, USB_EXPECTED_LEN);
+    int& last = m_received[device];
+    m_receivedTotal += received - last;
+    last = received;
+
+    int perc = 100 * received / USB_EXPECTED_LEN;
+    int& lastProgress = m_progress[device];
+    if (perc != lastProgress) {
+        lastProgress = perc;
+        emitReceived(device, data, received);
+        emit deviceProgress(device, perc);
+        emit progress(qMin<qint64>(100, 100 * m_receivedTotal / (m_received.size() * USB_EXPECTED_LEN)));
     }
-    qDebug() << "[IN]" << s.toStdString().c_str();
+}
+
+void UsbDownloader::transportCompleted(const QString& device, const unsigned char* data, const int size)
+{
+    emitReceived(device, data, size);
 
-    UsbDownloaderData* usb_data = (UsbDownloaderData*) transfer->user_data;
+    QByteArray image((const char*) data, size);
+    emit deviceCompleted(device, image);
 
-#ifdef USB_WRITE_DUMP
-    if (usb_data->dump.isOpen() && usb_data->dump.isWritable()) {
-        QByteArray buffer((char *)transfer->buffer, transfer->actual_length);
-        usb_data->dump.write(buffer.toHex());
-        usb_data->dump.write("\n");
-    }
-#endif
+    // Emit completion signal
+    if (m_mode == FirstDevice)
+        emit completed(image);
+}
 
-    usb_data->data.append((char *)transfer->buffer, transfer->actual_length);
-    if (usb_data->data.size() >= USB_EXPECTED_LEN) {
-        usb_data->completed = true;
+void UsbDownloader::emitReceived(const QString& device, const unsigned char* data, const int size)
+{
+    int& emitted = m_emitted[device];
+    if (size <= emitted)
         return;
-    }
 
-    if (transfer->status == LIBUSB_TRANSFER_COMPLETED || transfer->status == LIBUSB_TRANSFER_OVERFLOW)
-        libusb_submit_transfer(transfer);
+    QByteArray chunk((const char*) data + emitted, size - emitted);
+    emitted = size;
+    emit deviceReceived(device, chunk);
+    if (m_mode == FirstDevice)
+        emit received(chunk);
+}
+
+void UsbDownloader::transportError(const QString& device)
+{
+    emit deviceError(device);
 }
 
 } // namespace Usb
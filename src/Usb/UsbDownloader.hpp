@@ -25,9 +25,12 @@
 #define USBDOWNLOADER_HPP
 
 #include <QtCore/QThread>
+#include <QtCore/QMutex>
 #include <QtCore/QByteArray>
+#include <QtCore/QString>
+#include <QtCore/QHash>
 
-class libusb_context;
+#include <Usb/UsbTransport.hpp>
 
 namespace BSM {
 namespace Usb {
@@ -38,12 +41,68 @@ namespace Usb {
  *
  * This class ask the scale for the data in its memory and then download them.
  * When the download is completed, a signal is emitted. A progress signal is also
- * emitted while downloading.
+ * emitted while downloading, together with the chunk of data received since the
+ * last one: the chunks can be fed to UsbData::feed() to parse the data while
+ * the download goes on.
+ *
+ * In the AllDevices mode every connected scale is downloaded at the same time:
+ * all the transfers are driven by the same libusb event loop and the result of
+ * each scale is reported by the device* signals, keyed by the USB bus/port path
+ * of the scale (e.g. \c "1-4.2").
+ *
+ * When autoDownload is enabled the thread keeps running and waits for the
+ * hotplug events: a download is started as soon as a scale is plugged in
+ * and its enumeration is settled. If the transport has no hotplug support,
+ * like the replay of a capture, a single download is done instead.
+ *
+ * The data come from a UsbTransport, selected at runtime: by default the
+ * real scales are used (UsbDeviceTransport). If the environment variable
+ * \c BSM_USB_REPLAY is set, the capture file it names is played back instead
+ * (UsbReplayTransport); if \c BSM_USB_CAPTURE is set, all the downloads are
+ * recorded to the file it names (UsbCaptureTransport).
  */
-class UsbDownloader : public QThread
+class UsbDownloader : public QThread, protected UsbTransport::Listener
 {
     Q_OBJECT
     Q_DISABLE_COPY(UsbDownloader)
+    Q_ENUMS(Mode)
+
+public:
+    /*! Download mode.
+     * \sa mode
+     */
+    enum Mode {
+        FirstDevice,    //!< Download only the first scale found
+        AllDevices      //!< Download all the connected scales in parallel
+    };
+
+private:
+    /*! The download mode.
+     *
+     * The mode must be set before starting the thread.
+     * \sa Mode getMode setMode
+     */
+    Q_PROPERTY(Mode mode READ getMode WRITE setMode);
+    /*! Start a download when a scale is plugged in.
+     *
+     * The property must be set before starting the thread.
+     * \sa getAutoDownload setAutoDownload
+     */
+    Q_PROPERTY(bool autoDownload READ getAutoDownload WRITE setAutoDownload);
+    /*! The number of interrupt transfers kept in flight for each scale.
+     *
+     * The value is between 1 (a single transfer, resubmitted on completion)
+     * and 32. The property must be set before starting a download.
+     * \sa getQueueDepth setQueueDepth
+     */
+    Q_PROPERTY(int queueDepth READ getQueueDepth WRITE setQueueDepth);
+    /*! The time in ms of the last download, from the request to the scales
+     * to the end of the data; \c -1 if no download was completed.
+     *
+     * Compare it with a queueDepth of 1 to measure the effect of the queue.
+     * \sa getDownloadTime
+     */
+    Q_PROPERTY(qint64 downloadTime READ getDownloadTime);
 
 public:
     /*! Constructor of the class.
@@ -52,26 +111,185 @@ public:
     explicit UsbDownloader(QObject* parent = 0);
     virtual ~UsbDownloader();
 
+    /*! Set the transport for the downloads.
+     *
+     * The transport must be set when the thread is not running.
+     * \param transport the new transport, owned by this object
+     */
+    void setTransport(UsbTransport* transport);
+
+    /*! Getter for the mode property.
+     * \sa Mode mode setMode
+     */
+    Mode getMode() const;
+
+    /*! Getter for the autoDownload property.
+     * \sa autoDownload setAutoDownload
+     */
+    bool getAutoDownload() const;
+
+    /*! Getter for the queueDepth property.
+     * \sa queueDepth setQueueDepth
+     */
+    int getQueueDepth() const;
+
+    /*! Getter for the downloadTime property.
+     * \sa downloadTime
+     */
+    qint64 getDownloadTime() const;
+
+public slots:
+    /*! Setter for the mode property.
+     * \param mode the new value
+     * \sa Mode mode getMode
+     */
+    void setMode(const Mode& mode);
+
+    /*! Setter for the autoDownload property.
+     * \param autoDownload the new value
+     * \sa autoDownload getAutoDownload
+     */
+    void setAutoDownload(const bool& autoDownload);
+
+    /*! Setter for the queueDepth property.
+     * \param queueDepth the new value, bounded between 1 and 32
+     * \sa queueDepth getQueueDepth
+     */
+    void setQueueDepth(const int& queueDepth);
+
+    /*! Start a download now.
+     *
+     * If the thread is running, the download is started without waiting for
+     * a hotplug event or after the current one; otherwise the thread is
+     * started.
+     */
+    void requestDownload();
+
+    //! Stop waiting for the scales and exit the thread.
+    void stopAutoDownload();
+
 signals:
+    //! A download is started.
+    void downloadStarted();
+
+    /*! A download is finished, with or without errors.
+     *
+     * The signal is emitted after the signals of all the scales.
+     */
+    void downloadFinished();
+
     /*! The download was completed.
+     *
+     * This signal is emitted only in the FirstDevice mode.
      * \param data the data downloaded
      */
     void completed(const QByteArray& data);
 
-    //! The download cannot be completed.
+    /*! Some data were received.
+     *
+     * This signal is emitted only in the FirstDevice mode, before the completed
+     * signal for the last chunk.
+     * \param chunk the data received since the last signal
+     */
+    void received(const QByteArray& chunk);
+
+    /*! The download cannot be completed.
+     *
+     * In the AllDevices mode this signal is emitted only if no scale was
+     * downloaded successfully.
+     */
     void error();
 
     /*! The download is in progress
+     *
+     * In the AllDevices mode the percentage is the overall one.
      * \param perc the percentage of the progress
      */
     void progress(const int perc);
 
+    /*! The download from a scale was completed.
+     * \param device the bus/port path of the scale
+     * \param data the data downloaded
+     */
+    void deviceCompleted(const QString& device, const QByteArray& data);
+
+    /*! Some data were received from a scale.
+     * \param device the bus/port path of the scale
+     * \param chunk the data received since the last signal
+     */
+    void deviceReceived(const QString& device, const QByteArray& chunk);
+
+    /*! The download from a scale cannot be completed.
+     * \param device the bus/port path of the scale
+     */
+    void deviceError(const QString& device);
+
+    /*! The download from a scale is in progress
+     * \param device the bus/port path of the scale
+     * \param perc the percentage of the progress
+     */
+    void deviceProgress(const QString& device, const int perc);
+
 protected:
-    //! The libusb context.
-    libusb_context* ctx;
+    //! The source of the data.
+    UsbTransport* m_transport;
+
+    //! mode property value. \sa mode getMode setMode
+    Mode m_mode;
+
+    //! autoDownload property value. \sa autoDownload getAutoDownload setAutoDownload
+    bool m_autoDownload;
+
+    //! queueDepth property value. \sa queueDepth getQueueDepth setQueueDepth
+    int m_queueDepth;
+
+    //! downloadTime property value. \sa downloadTime getDownloadTime
+    qint64 m_downloadTime;
+
+    //! Set to stop waiting for the scales.
+    volatile int m_stop;
+
+    //! Set to start a download without waiting for the scales.
+    volatile int m_requested;
+
+    //! Set when the thread does not serve the requests anymore and is going to exit.
+    bool m_exiting;
+
+    //! Mutex for m_stop, m_requested and m_exiting.
+    QMutex m_mutex;
+
+    //! The bytes received from each scale in the current download.
+    QHash<QString, int> m_received;
+
+    //! The bytes received from all the scales in the current download.
+    qint64 m_receivedTotal;
+
+    //! The last progress reported for each scale in the current download.
+    QHash<QString, int> m_progress;
+
+    //! The bytes of each scale already emitted by the received signals.
+    QHash<QString, int> m_emitted;
 
     //! The starting point for the thread.
     virtual void run();
+
+    /*! Emit the data received from a scale since the last call.
+     * \param device the identifier of the scale
+     * \param data all the data received so far
+     * \param size the size in byte of the data to emit up to
+     */
+    void emitReceived(const QString& device, const unsigned char* data, const int size);
+
+    //! Download the data from the scales.
+    void download();
+
+    //! Wait for the scales and download them when plugged in.
+    void monitor();
+
+    virtual void transportStarted(const QString& device);
+    virtual void transportReceived(const QString& device, const unsigned char* data, const int size);
+    virtual void transportCompleted(const QString& device, const unsigned char* data, const int size);
+    virtual void transportError(const QString& device);
 };
 
 } // namespace Usb
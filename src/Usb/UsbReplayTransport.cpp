@@ -0,0 +1,172 @@
+/*!
+ * \file UsbReplayTransport.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbReplayTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbReplayTransport.hpp"
+#include "UsbCaptureTransport.hpp"
+
+#include <string.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QSet>
+#include <QtCore/QtEndian>
+
+namespace BSM {
+namespace Usb {
+
+UsbReplayTransport::UsbReplayTransport(const QString& fileName)
+    : UsbTransport()
+    , m_file(fileName)
+    , m_map(0)
+    , m_size(0)
+    , m_next(0)
+{
+    if (!m_file.open(QIODevice::ReadOnly)) {
+        qCritical() << "Cannot open capture file" << fileName;
+        return;
+    }
+
+    m_size = m_file.size();
+    if (m_size < USB_CAPTURE_MAGIC_LEN) {
+        qCritical() << "Invalid capture file" << fileName;
+        return;
+    }
+    m_map = m_file.map(0, m_size);
+    if (!m_map) {
+        qCritical() << "Cannot map capture file" << fileName;
+        return;
+    }
+    if (memcmp(m_map, USB_CAPTURE_MAGIC, USB_CAPTURE_MAGIC_LEN) != 0 &&
+        memcmp(m_map, USB_CAPTURE_MAGIC_V1, USB_CAPTURE_MAGIC_LEN) != 0
+    ) {
+        qCritical() << "Invalid capture file" << fileName;
+        m_file.unmap(m_map);
+        m_map = 0;
+        return;
+    }
+
+    // Index the records, a truncated record at the end is ignored
+    qint64 offset = USB_CAPTURE_MAGIC_LEN;
+    while (offset + USB_CAPTURE_HEADER_LEN <= m_size) {
+        quint32 dataLen = qFromLittleEndian<quint32>(m_map + offset + 8);
+        quint16 idLen = qFromLittleEndian<quint16>(m_map + offset + 12);
+        quint16 chunks = qFromLittleEndian<quint16>(m_map + offset + 14);
+        qint64 next = offset + USB_CAPTURE_HEADER_LEN + idLen + 4 * chunks + dataLen;
+        if (next > m_size)
+            break;
+        // A scale never sends more than its memory image
+        if (dataLen > USB_EXPECTED_LEN)
+            qWarning() << "Skipping a record of" << dataLen << "bytes, more than" << USB_EXPECTED_LEN;
+        else
+            m_records.append(offset);
+        offset = next;
+    }
+    qDebug() << "Replaying" << m_records.size() << "records from" << fileName;
+}
+
+UsbReplayTransport::~UsbReplayTransport()
+{
+    if (m_map)
+        m_file.unmap(m_map);
+    if (m_file.isOpen())
+        m_file.close();
+}
+
+bool UsbReplayTransport::isValid() const
+{
+    return (m_map != 0);
+}
+
+int UsbReplayTransport::getRecordCount() const
+{
+    return m_records.size();
+}
+
+QString UsbReplayTransport::getName() const
+{
+    return "replay of " + m_file.fileName();
+}
+
+bool UsbReplayTransport::download(const bool allDevices, const int queueDepth, Listener* listener)
+{
+    Q_UNUSED(queueDepth);
+
+    if (m_records.isEmpty()) {
+        qCritical() << "No records to replay";
+        return false;
+    }
+
+    if (allDevices) {
+        // The records of a captured download are consecutive, one for each scale
+        QSet<QString> devices;
+        int first = m_next;
+        do {
+            qint64 offset = m_records.at(m_next);
+            QString id = device(offset);
+            if (devices.contains(id))
+                break;
+            devices.insert(id);
+            replay(offset, listener);
+            m_next = (m_next + 1) % m_records.size();
+        } while (m_next != first);
+    }
+    else {
+        replay(m_records.at(m_next), listener);
+        m_next = (m_next + 1) % m_records.size();
+    }
+
+    return true;
+}
+
+QString UsbReplayTransport::device(const qint64 offset) const
+{
+    const uchar* header = m_map + offset;
+    quint16 idLen = qFromLittleEndian<quint16>(header + 12);
+    return QString::fromUtf8((const char*) header + USB_CAPTURE_HEADER_LEN, idLen);
+}
+
+void UsbReplayTransport::replay(const qint64 offset, Listener* listener)
+{
+    const uchar* header = m_map + offset;
+    quint32 dataLen = qFromLittleEndian<quint32>(header + 8);
+    quint16 idLen = qFromLittleEndian<quint16>(header + 12);
+    quint16 chunks = qFromLittleEndian<quint16>(header + 14);
+    const uchar* sizes = header + USB_CAPTURE_HEADER_LEN + idLen;
+    const uchar* data = sizes + 4 * chunks;
+
+    QString id = device(offset);
+    listener->transportStarted(id);
+    quint32 received = 0;
+    for (int i = 0; i < chunks; ++i) {
+        quint32 size = qFromLittleEndian<quint32>(sizes + 4 * i);
+        if (size <= received || size > dataLen)
+            continue;
+        received = size;
+        listener->transportReceived(id, data, size);
+    }
+    if (received < dataLen)
+        listener->transportReceived(id, data, dataLen);
+    listener->transportCompleted(id, data, dataLen);
+}
+
+} // namespace Usb
+} // namespace BSM
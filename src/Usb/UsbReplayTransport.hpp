@@ -0,0 +1,93 @@
+/*!
+ * \file UsbReplayTransport.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbReplayTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBREPLAYTRANSPORT_HPP
+#define USBREPLAYTRANSPORT_HPP
+
+#include <Usb/UsbTransport.hpp>
+
+#include <QtCore/QFile>
+#include <QtCore/QVector>
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \class BSM::Usb::UsbReplayTransport
+ * \brief Transport that plays back a capture file.
+ *
+ * The capture file, written by UsbCaptureTransport, is memory-mapped and the
+ * records are passed to the listener straight from the mapping, so thousands
+ * of downloads can be replayed at memory speed.
+ *
+ * The data of each record are delivered in the chunks recorded with them, the
+ * files without the chunks deliver all the data at once.
+ *
+ * When downloading the first scale only, each download plays back the next
+ * record, starting again from the first one at the end of the file. When
+ * downloading all the scales, each download plays back the next records up to
+ * a scale already played back, so each scale is downloaded once as in the
+ * captured downloads.
+ */
+class UsbReplayTransport : public UsbTransport
+{
+public:
+    /*! Constructor of the class.
+     * \param fileName the capture file
+     */
+    explicit UsbReplayTransport(const QString& fileName);
+    virtual ~UsbReplayTransport();
+
+    //! Check if the capture file was mapped and is valid.
+    bool isValid() const;
+
+    //! Get the number of records in the capture file.
+    int getRecordCount() const;
+
+    virtual QString getName() const;
+    virtual bool download(const bool allDevices, const int queueDepth, Listener* listener);
+
+private:
+    /*! Get the scale of a record.
+     * \param offset the offset of the record in the file
+     * \return the identifier of the scale
+     */
+    QString device(const qint64 offset) const;
+
+    /*! Play back a record.
+     * \param offset the offset of the record in the file
+     * \param listener the receiver of the events
+     */
+    void replay(const qint64 offset, Listener* listener);
+
+    QFile               m_file;
+    uchar*              m_map;
+    qint64              m_size;
+    QVector<qint64>     m_records;
+    int                 m_next;
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBREPLAYTRANSPORT_HPP
@@ -0,0 +1,98 @@
+/*!
+ * \file UsbSampleKernel.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the scalar and SSE2 decoding kernels of the samples
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbSampleKernel.hpp"
+#include "UsbSampleKernelPrivate.hpp"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \brief The kernel selected for the CPU.
+ *
+ * The kernel is selected by the constructor of a static instance, before
+ * main() and so before any thread is started: it is only read afterwards.
+ */
+struct SampleKernel
+{
+    void (*func)(const unsigned char* src, const int count, unsigned short* dst);   //!< The kernel
+    const char* name;                                                               //!< The name of the kernel
+
+    SampleKernel()
+    {
+#if defined(USB_KERNEL_AVX2) && defined(__GNUC__)
+        __builtin_cpu_init();
+        if (__builtin_cpu_supports("avx2")) {
+            name = "AVX2";
+            func = swapSamplesAvx2;
+            return;
+        }
+#endif
+#ifdef __SSE2__
+        name = "SSE2";
+        func = swapSamplesSse2;
+#else
+        name = "scalar";
+        func = swapSamplesScalar;
+#endif
+    }
+};
+
+//! The kernel selected for the CPU
+static const SampleKernel sampleKernel;
+
+void swapSamples(const uchar* src, const int count, quint16* dst)
+{
+    sampleKernel.func(src, count, dst);
+}
+
+const char* sampleKernelName()
+{
+    return sampleKernel.name;
+}
+
+void swapSamplesScalar(const unsigned char* src, const int count, unsigned short* dst)
+{
+    for (int i = 0; i < count; ++i)
+        dst[i] = (quint16(src[2 * i]) << 8) | src[2 * i + 1];
+}
+
+#ifdef __SSE2__
+void swapSamplesSse2(const unsigned char* src, const int count, unsigned short* dst)
+{
+    int i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m128i v = _mm_loadu_si128((const __m128i*) (src + 2 * i));
+        v = _mm_or_si128(_mm_slli_epi16(v, 8), _mm_srli_epi16(v, 8));
+        _mm_storeu_si128((__m128i*) (dst + i), v);
+    }
+    swapSamplesScalar(src + 2 * i, count - i, dst + i);
+}
+#endif
+
+} // namespace Usb
+} // namespace BSM
@@ -0,0 +1,48 @@
+/*!
+ * \file UsbSampleKernel.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the decoding kernels of the samples
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBSAMPLEKERNEL_HPP
+#define USBSAMPLEKERNEL_HPP
+
+#include <QtCore/QtGlobal>
+
+namespace BSM {
+namespace Usb {
+
+/*! Convert a span of big-endian 16 bits samples to host order.
+ *
+ * The kernel is selected at the first call, according to the CPU: AVX2, SSE2
+ * or plain C++.
+ * \param src the big-endian samples
+ * \param count the number of samples
+ * \param dst the converted samples
+ */
+void swapSamples(const uchar* src, const int count, quint16* dst);
+
+//! Get the name of the kernel used by swapSamples(), for the logs.
+const char* sampleKernelName();
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBSAMPLEKERNEL_HPP
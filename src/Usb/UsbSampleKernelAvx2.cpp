@@ -0,0 +1,46 @@
+/*!
+ * \file UsbSampleKernelAvx2.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the AVX2 decoding kernel of the samples
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+// This file is built with -mavx2: its code must run only when the CPU supports it,
+// and it must not include headers with inline code shared with the other files.
+
+#include "UsbSampleKernelPrivate.hpp"
+
+#include <immintrin.h>
+
+namespace BSM {
+namespace Usb {
+
+void swapSamplesAvx2(const unsigned char* src, const int count, unsigned short* dst)
+{
+    int i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m256i v = _mm256_loadu_si256((const __m256i*) (src + 2 * i));
+        v = _mm256_or_si256(_mm256_slli_epi16(v, 8), _mm256_srli_epi16(v, 8));
+        _mm256_storeu_si256((__m256i*) (dst + i), v);
+    }
+    swapSamplesSse2(src + 2 * i, count - i, dst + i);
+}
+
+} // namespace Usb
+} // namespace BSM
@@ -0,0 +1,46 @@
+/*!
+ * \file UsbSampleKernelPrivate.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the kernels of the samples, for each instruction set
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBSAMPLEKERNELPRIVATE_HPP
+#define USBSAMPLEKERNELPRIVATE_HPP
+
+// This header is included by the AVX2 kernel too: it must not include
+// headers with inline code, see UsbSampleKernelAvx2.cpp.
+
+/*! \cond PRIVATE */
+namespace BSM {
+namespace Usb {
+
+void swapSamplesScalar(const unsigned char* src, const int count, unsigned short* dst);
+#ifdef __SSE2__
+void swapSamplesSse2(const unsigned char* src, const int count, unsigned short* dst);
+#endif
+#ifdef USB_KERNEL_AVX2
+void swapSamplesAvx2(const unsigned char* src, const int count, unsigned short* dst);
+#endif
+
+} // namespace Usb
+} // namespace BSM
+/*! \endcond */
+
+#endif // USBSAMPLEKERNELPRIVATE_HPP
@@ -0,0 +1,500 @@
+/*!
+ * \file UsbScaleData.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbScaleParser class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbScaleData.hpp"
+#include "UsbSampleKernel.hpp"
+#include "UsbScaleLayout.hpp"
+#include "UsbTransport.hpp"
+
+#include <QtCore/QtEndian>
+
+#include <algorithm>
+#include <cstring>
+
+//! First multiplier of the image hash
+#define HASH_PRIME1         Q_UINT64_C(0x9E3779B185EBCA87)
+//! Second multiplier of the image hash
+#define HASH_PRIME2         Q_UINT64_C(0xC2B2AE3D27D4EB4F)
+
+namespace BSM {
+namespace Usb {
+
+/*! Convert two bytes to a unsigned short.
+ * \param b1 the higher byte
+ * \param b2 the lower byte
+ * \return the unsigned short
+ */
+static inline quint16 uchar2ushort(const uchar b1, const uchar b2)
+{
+    return (quint16(b1) << 8) | b2;
+}
+
+/*! Convert a scale date and time.
+ * \param date the date bytes
+ * \param time the time bytes
+ * \return the minutes since the epoch, or Data::Timestamp::Invalid
+ */
+static inline qint64 scaleMinutes(const uchar* date, const uchar* time)
+{
+    return Data::Timestamp::scaleMinutes(uchar2ushort(date[0], date[1]), time[0], time[1]);
+}
+
+/*! Get the index of the oldest sample of a user.
+ * \tparam L the layout of the scale
+ * \param data the memory image of the scale, up to the pointer block
+ * \param index the index of the user
+ * \return the index of the oldest sample in the rows of the user
+ */
+template<class L>
+static inline int firstSample(const uchar* data, const int index)
+{
+    // When the memory is full, the oldest sample is the one after the pointer
+    if (data[L::ExtraBlockOff + index * L::ExtraUserLen + 5] != L::NumSamples)
+        return 0;
+    return data[L::PtrBlockOff + index] % L::NumSamples;
+}
+
+/*! Decode contiguous samples of a user block.
+ * \tparam L the layout of the scale
+ * \param block the user block
+ * \param slot the index of the first sample in the rows
+ * \param length the number of samples
+ * \param offset the index of the first sample in the structure
+ * \param user the structure to fill
+ */
+template<class L>
+static void decodeUserSpan(const uchar* block, const int slot, const int length, const int offset, UsbUserSamples* user)
+{
+    const uchar* row = block + slot * L::SampleLen;
+    swapSamples(row + L::WeightVar * L::VarLen, length, user->weight + offset);
+    swapSamples(row + L::BodyFatVar * L::VarLen, length, user->bodyFat + offset);
+    swapSamples(row + L::WaterVar * L::VarLen, length, user->water + offset);
+    swapSamples(row + L::MuscleVar * L::VarLen, length, user->muscle + offset);
+
+    const uchar* date = row + L::DateVar * L::VarLen;
+    const uchar* time = row + L::TimeVar * L::VarLen;
+    qint64* timestamp = user->timestamp + offset;
+    for (int sample = 0; sample < length; ++sample)
+        timestamp[sample] = scaleMinutes(date + sample * L::SampleLen, time + sample * L::SampleLen);
+}
+
+/*! Decode the samples of a user block, from the oldest one.
+ *
+ * The rows are circular: the samples are decoded as two contiguous spans.
+ * \tparam L the layout of the scale
+ * \param block the user block
+ * \param first the index of the oldest sample in the rows
+ * \param from the first sample to decode, counting from the oldest one
+ * \param count the number of samples in the rows
+ * \param user the structure to fill, starting with the sample \p from
+ */
+template<class L>
+static void decodeUserRange(const uchar* block, const int first, const int from, const int count, UsbUserSamples* user)
+{
+    int slot = (first + from) % L::NumSamples;
+    int length = count - from;
+    int head = qMin(length, L::NumSamples - slot);
+    decodeUserSpan<L>(block, slot, head, 0, user);
+    if (head < length)
+        decodeUserSpan<L>(block, 0, length - head, head, user);
+}
+
+/*! Move the samples decoded in the order of the rows, from a sample.
+ *
+ * The samples decoded before the pointers are known start from the first row:
+ * they are rotated to start from the sample \p from, counting from the oldest one.
+ * \tparam L the layout of the scale
+ * \param first the index of the oldest sample in the rows
+ * \param from the first sample to keep, counting from the oldest one
+ * \param user the structure with the samples of all the rows
+ */
+template<class L>
+static void alignUser(const int first, const int from, UsbUserSamples* user)
+{
+    const int start = (first + from) % L::NumSamples;
+    if (!start)
+        return;
+    std::rotate(user->weight, user->weight + start, user->weight + L::NumSamples);
+    std::rotate(user->bodyFat, user->bodyFat + start, user->bodyFat + L::NumSamples);
+    std::rotate(user->water, user->water + start, user->water + L::NumSamples);
+    std::rotate(user->muscle, user->muscle + start, user->muscle + L::NumSamples);
+    std::rotate(user->timestamp, user->timestamp + start, user->timestamp + L::NumSamples);
+}
+
+/*! Find the first sample written after a cursor.
+ *
+ * The number of samples written since the cursor is checked against the
+ * timestamp of the newest sample known: if the user was reset or the ring
+ * was overwritten completely, all the samples must be decoded.
+ * \tparam L the layout of the scale
+ * \param block the user block
+ * \param first the index of the oldest sample in the rows
+ * \param reported the number of samples reported by the scale
+ * \param count the number of samples in the rows
+ * \param cursor the cursor of the last download
+ * \return the first new sample, counting from the oldest one; \c 0 to decode all of them
+ */
+template<class L>
+static int firstNewSample(const uchar* block, const int first, const int reported, const int count, const Data::SampleCursor& cursor)
+{
+    if (cursor.timestamp == Data::Timestamp::Invalid)
+        return 0;
+
+    // Samples written since the ring was empty, the full rings are counted only once
+    int written = (reported == L::NumSamples) ? L::NumSamples + first : reported;
+    int previous = (cursor.count == L::NumSamples) ? L::NumSamples + cursor.pointer % L::NumSamples : cursor.count;
+    int added;
+    if (reported == L::NumSamples)
+        added = ((written - previous) % L::NumSamples + L::NumSamples) % L::NumSamples;
+    else if (written >= previous)
+        added = written - previous;
+    else
+        return 0;
+
+    int from = count - added;
+    if (from < 1)
+        return 0;
+
+    // The sample before the new ones must be the newest one known
+    int slot = (first + from - 1) % L::NumSamples;
+    const uchar* date = block + L::DateVar * L::VarLen + slot * L::SampleLen;
+    const uchar* time = block + L::TimeVar * L::VarLen + slot * L::SampleLen;
+    if (scaleMinutes(date, time) != cursor.timestamp)
+        return 0;
+
+    return from;
+}
+
+/*! Mark a slot of the users as not used.
+ * \param user the slot of the user
+ */
+static inline void clearUser(UsbUserSamples* user)
+{
+    user->id = 0;
+    user->numSamples = 0;
+    user->partial = 0;
+}
+
+/*! Decode a user with the extra and the pointer blocks.
+ * \tparam L the layout of the scale
+ * \param data the memory image of the scale
+ * \param index the index of the user
+ * \param state the state of the parser
+ */
+template<class L>
+static void decodeUser(const uchar* data, const int index, const UsbScaleParserState* state)
+{
+    const uchar* extra = data + L::ExtraBlockOff + index * L::ExtraUserLen;
+    const uchar* block = data + index * L::UserLen;
+    UsbUserSamples* user = &state->target->users[index];
+
+    user->id = extra[0];
+    if (user->id < 1 || user->id > L::NumUsers) {
+        clearUser(user);
+        return;
+    }
+
+    user->height = extra[1];
+    user->birthDate = uchar2ushort(extra[2], extra[3]);
+    user->female = ((extra[4] & 0x80) == 0x00) ? 0 : 1;
+    user->activity = extra[4] & 0x0F;
+    if (user->activity > 4) {
+        // Invalid value, set to None
+        user->activity = 0;
+    }
+
+    int reported = extra[5];
+    int count = qMin(reported, int(L::NumSamples));
+    int first = firstSample<L>(data, index);
+    // Only the samples after the cursor are needed
+    int from = 0;
+    if (state->cursors)
+        from = firstNewSample<L>(block, first, reported, count, state->cursors[user->id - 1]);
+    if (state->earlyUsers & (1u << index))
+        alignUser<L>(first, from, user);
+    else
+        decodeUserRange<L>(block, first, from, count, user);
+
+    // The samples end with the first invalid date
+    int decoded = count - from;
+    int sample = 0;
+    while (sample < decoded && user->timestamp[sample] != Data::Timestamp::Invalid)
+        ++sample;
+    user->numSamples = sample;
+    user->partial = (from > 0) ? 1 : 0;
+
+    // Cursor for the next download
+    user->cursor.count = reported;
+    user->cursor.pointer = first;
+    if (sample > 0)
+        user->cursor.timestamp = user->timestamp[sample - 1];
+    else if (from > 0)
+        user->cursor.timestamp = state->cursors[user->id - 1].timestamp;
+    else
+        user->cursor.timestamp = Data::Timestamp::Invalid;
+}
+
+/*! Find the users changed since the previous image of the scale.
+ *
+ * A user is changed if a byte of its block, of its entry in the extra block
+ * or its pointer differs. The bytes in the gaps of the extra block belong to
+ * no user: if one of them differs, all the users are changed.
+ * \tparam L the layout of the scale
+ * \param previous the previous memory image of the scale
+ * \param data the memory image of the scale, up to the pointer block
+ * \return the changed users, one bit for each index
+ */
+template<class L>
+static quint32 diffLayout(const uchar* previous, const uchar* data)
+{
+    const int usersLen = L::NumUsers * L::UserLen;
+    const int gapOff = L::ExtraBlockOff + L::NumUsers * L::ExtraUserLen;
+    if (memcmp(previous + usersLen, data + usersLen, L::ExtraBlockOff - usersLen) != 0 ||
+        memcmp(previous + gapOff, data + gapOff, L::PtrBlockOff - gapOff) != 0
+    ) {
+        return (1u << L::NumUsers) - 1;
+    }
+
+    quint32 changed = 0;
+    for (int user = 0; user < L::NumUsers; ++user) {
+        const int blockOff = user * L::UserLen;
+        const int extraOff = L::ExtraBlockOff + user * L::ExtraUserLen;
+        if (memcmp(previous + blockOff, data + blockOff, L::UserLen) != 0 ||
+            memcmp(previous + extraOff, data + extraOff, L::ExtraUserLen) != 0 ||
+            previous[L::PtrBlockOff + user] != data[L::PtrBlockOff + user]
+        ) {
+            changed |= 1u << user;
+        }
+    }
+    return changed;
+}
+
+/*! Decode what is complete in the data received so far.
+ * \tparam L the layout of the scale
+ * \param state the state of the parser
+ * \param data all the data received so far
+ * \param size the size in byte of the data received so far
+ * \return the combination of the UsbScaleParser::Stage values completed by this call
+ */
+template<class L>
+static int feedLayout(UsbScaleParserState* state, const uchar* data, const int size)
+{
+    // The layout must fit in UsbScaleData and in the kernels
+    (void) sizeof(UsbLayoutCheck<(L::NumUsers <= USB_MAX_USERS)>);
+    (void) sizeof(UsbLayoutCheck<(L::NumSamples <= USB_MAX_SAMPLES)>);
+    (void) sizeof(UsbLayoutCheck<(L::SampleLen == 2)>);
+    (void) sizeof(UsbLayoutCheck<(L::ExpectedLen <= USB_EXPECTED_LEN)>);
+
+    UsbScaleData* target = state->target;
+    int stages = UsbScaleParser::NoStage;
+
+    // The blocks of the users come first: without the pointers all their rows are
+    // decoded as they are received, while the rest of the image is downloaded.
+    // A block equal to the previous image is left for the pointers, that tell
+    // if the user changed at all
+    if (size < L::PtrBlockOff + L::NumUsers) {
+        while (state->decodedUsers < L::NumUsers && size >= (state->decodedUsers + 1) * L::UserLen) {
+            const int blockOff = state->decodedUsers * L::UserLen;
+            if (!state->previous || memcmp(state->previous + blockOff, data + blockOff, L::UserLen) != 0) {
+                decodeUserRange<L>(data + blockOff, 0, 0, L::NumSamples, &target->users[state->decodedUsers]);
+                state->earlyUsers |= 1u << state->decodedUsers;
+                stages |= UsbScaleParser::UserBlocks;
+            }
+            ++state->decodedUsers;
+        }
+    }
+
+    // The parameters of the users and the pointers to the samples come next
+    if (!state->usersDecoded && size >= L::PtrBlockOff + L::NumUsers) {
+        state->changedUsers = state->previous ? diffLayout<L>(state->previous, data) : (1u << L::NumUsers) - 1;
+        for (int user = 0; user < L::NumUsers; ++user) {
+            if (state->changedUsers & (1u << user))
+                decodeUser<L>(data, user, state);
+            else
+                clearUser(&target->users[user]);
+        }
+        for (int user = L::NumUsers; user < USB_MAX_USERS; ++user)
+            clearUser(&target->users[user]);
+        state->usersDecoded = true;
+        stages |= UsbScaleParser::Users;
+    }
+
+    // The date and the time of the scale come last
+    if (!state->completed && size >= L::ExpectedLen) {
+        target->dateTime = scaleMinutes(data + L::ScaleDateOff, data + L::ScaleTimeOff);
+        state->completed = true;
+        stages |= UsbScaleParser::Completed;
+    }
+
+    return stages;
+}
+
+/*! Hash a span of bytes, 8 at a time.
+ *
+ * Each word is multiplied, mixed into the hash and rotated, like xxHash does;
+ * the words are read as little-endian so the hashes saved on the DB do not
+ * depend on the host.
+ * \param hash the hash so far
+ * \param data the bytes
+ * \param size the number of bytes
+ * \return the updated hash
+ */
+static quint64 hashBytes(quint64 hash, const uchar* data, const int size)
+{
+    int i = 0;
+    for (; i + 8 <= size; i += 8) {
+        hash ^= qFromLittleEndian<quint64>(data + i) * HASH_PRIME2;
+        hash = ((hash << 31) | (hash >> 33)) * HASH_PRIME1;
+    }
+    for (; i < size; ++i) {
+        hash ^= data[i] * HASH_PRIME1;
+        hash = ((hash << 11) | (hash >> 53)) * HASH_PRIME2;
+    }
+    return hash;
+}
+
+/*! Hash the content of a memory image.
+ *
+ * The date and the time of the scale are skipped: they change at each
+ * download even if no user stepped on the scale.
+ * \tparam L the layout of the scale
+ * \param data the memory image of the scale
+ * \param size the size in byte of the image
+ * \return the hash of the image
+ */
+template<class L>
+static quint64 hashLayout(const uchar* data, const int size)
+{
+    quint64 hash = HASH_PRIME1 * quint64(size);
+    if (size != L::ExpectedLen)
+        hash = hashBytes(hash, data, size);
+    else {
+        hash = hashBytes(hash, data, L::ScaleDateOff);
+        hash = hashBytes(hash, data + L::ScaleTimeOff + L::ScaleTimeLen, size - L::ScaleTimeOff - L::ScaleTimeLen);
+    }
+
+    // Final avalanche, from MurmurHash3
+    hash ^= hash >> 33;
+    hash *= Q_UINT64_C(0xFF51AFD7ED558CCD);
+    hash ^= hash >> 33;
+    hash *= Q_UINT64_C(0xC4CEB9FE1A85EC53);
+    hash ^= hash >> 33;
+    return hash;
+}
+
+//! The BF 480 USB layout
+typedef UsbScaleLayout<UsbLayoutBF480> LayoutBF480;
+
+//! The registry of the supported models, the first one is the default
+static const UsbScaleModel scaleModels[] = {
+    { LayoutBF480::VendorId, LayoutBF480::ProductId, "BF 480 USB", LayoutBF480::ExpectedLen, feedLayout<LayoutBF480>, hashLayout<LayoutBF480> }
+};
+
+//! Number of supported models
+static const int numScaleModels = sizeof(scaleModels) / sizeof(scaleModels[0]);
+
+const UsbScaleModel* UsbScaleModel::find(const quint16 vendorId, const quint16 productId)
+{
+    for (int i = 0; i < numScaleModels; ++i) {
+        if (scaleModels[i].vendorId == vendorId && scaleModels[i].productId == productId)
+            return &scaleModels[i];
+    }
+    return 0;
+}
+
+const UsbScaleModel* UsbScaleModel::getDefault()
+{
+    return &scaleModels[0];
+}
+
+UsbScaleParser::UsbScaleParser(UsbScaleData* target, const UsbScaleModel* model)
+    : m_model(model ? model : UsbScaleModel::getDefault())
+{
+    m_state.target = target;
+    m_state.cursors = 0;
+    m_state.previous = 0;
+    reset();
+}
+
+const UsbScaleModel* UsbScaleParser::getModel() const
+{
+    return m_model;
+}
+
+void UsbScaleParser::setModel(const UsbScaleModel* model)
+{
+    m_model = model ? model : UsbScaleModel::getDefault();
+    reset();
+}
+
+void UsbScaleParser::setCursors(const Data::SampleCursor* cursors)
+{
+    m_state.cursors = cursors;
+}
+
+void UsbScaleParser::setPrevious(const uchar* previous)
+{
+    m_state.previous = previous;
+}
+
+quint32 UsbScaleParser::getChangedUsers() const
+{
+    return m_state.changedUsers;
+}
+
+void UsbScaleParser::reset()
+{
+    m_state.changedUsers = 0;
+    m_state.decodedUsers = 0;
+    m_state.earlyUsers = 0;
+    m_state.usersDecoded = false;
+    m_state.completed = false;
+}
+
+int UsbScaleParser::feed(const uchar* data, const int size)
+{
+    return m_model->feed(&m_state, data, size);
+}
+
+bool UsbScaleParser::isCompleted() const
+{
+    return m_state.completed;
+}
+
+int UsbScaleParser::imageSize() const
+{
+    return m_model->imageSize;
+}
+
+bool UsbScaleParser::decode(const uchar* data, const int size, UsbScaleData* target, const UsbScaleModel* model)
+{
+    UsbScaleParser parser(target, model);
+    if (size != parser.imageSize())
+        return false;
+
+    parser.feed(data, size);
+    return true;
+}
+
+} // namespace Usb
+} // namespace BSM
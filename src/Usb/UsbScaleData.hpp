@@ -0,0 +1,227 @@
+/*!
+ * \file UsbScaleData.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbScaleData structure and the UsbScaleParser class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBSCALEDATA_HPP
+#define USBSCALEDATA_HPP
+
+#include <QtCore/QtGlobal>
+
+#include <Data/Timestamp.hpp>
+#include <Data/SampleCursor.hpp>
+
+//! Maximum number of users in the scale memory
+#define USB_MAX_USERS       10
+//! Maximum number of samples for each user
+#define USB_MAX_SAMPLES     60
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \struct BSM::Usb::UsbUserSamples
+ * \brief Decoded data of a user of the scale.
+ *
+ * The samples are stored as parallel arrays, ordered from the oldest to the
+ * newest. The values are in tenths (of kg or of percent), the timestamps are
+ * in minutes since the epoch (see Data::Timestamp).
+ *
+ * When the parser has the cursors of the last download, only the samples
+ * written after them are decoded and \c partial is set.
+ */
+struct UsbUserSamples
+{
+    quint8  id;                             //!< ID of the user, \c 0 if the slot is not used
+    quint8  height;                         //!< Height in cm
+    quint16 birthDate;                      //!< Birth date, as a scale date word
+    quint8  female;                         //!< \c 1 for a female user, \c 0 for a male one
+    quint8  activity;                       //!< Degree of activity, from 0 (none) to 4 (very high)
+    quint8  numSamples;                     //!< Number of valid samples
+    quint8  partial;                        //!< \c 1 if only the samples after the cursor were decoded
+    Data::SampleCursor cursor;              //!< Cursor of the user for the next download
+
+    quint16 weight[USB_MAX_SAMPLES];        //!< Weight, in tenths of kg
+    quint16 bodyFat[USB_MAX_SAMPLES];       //!< Body fat, in tenths of percent
+    quint16 water[USB_MAX_SAMPLES];         //!< Water, in tenths of percent
+    quint16 muscle[USB_MAX_SAMPLES];        //!< Muscle, in tenths of percent
+    qint64  timestamp[USB_MAX_SAMPLES];     //!< Date and time of the sample, in minutes since the epoch
+};
+
+/*!
+ * \struct BSM::Usb::UsbScaleData
+ * \brief Decoded data of the memory of the scale.
+ *
+ * A plain structure with a fixed capacity: decoding into it needs no heap
+ * allocation, and it can be copied or reused for the next download.
+ * \sa UsbScaleParser
+ */
+struct UsbScaleData
+{
+    qint64          dateTime;               //!< Date and time of the scale, in minutes since the epoch
+    UsbUserSamples  users[USB_MAX_USERS];   //!< The users, in the order of the scale memory
+};
+
+/*!
+ * \struct BSM::Usb::UsbScaleParserState
+ * \brief Progress of a UsbScaleParser in the memory image.
+ */
+struct UsbScaleParserState
+{
+    UsbScaleData*   target;         //!< The structure to fill
+    const Data::SampleCursor* cursors; //!< The cursors of the last download by user ID, or \c 0
+    const uchar*    previous;       //!< The image of the last download, or \c 0
+    quint32         changedUsers;   //!< The users changed since the last download, one bit for each index
+    int             decodedUsers;   //!< The number of user blocks checked before the pointers
+    quint32         earlyUsers;     //!< The users decoded before the pointers, one bit for each index
+    bool            usersDecoded;   //!< The users were completed with the extra and the pointer blocks
+    bool            completed;      //!< The whole image was decoded
+};
+
+/*!
+ * \struct BSM::Usb::UsbScaleModel
+ * \brief A supported scale model.
+ *
+ * Each model has a parser instantiated for its UsbScaleLayout; the models are
+ * found at runtime by their USB Vendor and Product IDs.
+ */
+struct UsbScaleModel
+{
+    quint16     vendorId;   //!< USB Vendor ID
+    quint16     productId;  //!< USB Product ID
+    const char* name;       //!< Name of the model
+    int         imageSize;  //!< Size in byte of the memory image
+
+    //! Parser of the model. \sa UsbScaleParser::feed
+    int (*feed)(UsbScaleParserState* state, const uchar* data, const int size);
+
+    /*! Hash of the content of a memory image of the model.
+     *
+     * The date and the time of the scale are not part of the content, so two
+     * downloads with no new samples have the same hash.
+     */
+    quint64 (*hash)(const uchar* data, const int size);
+
+    /*! Find a supported model.
+     * \param vendorId the USB Vendor ID
+     * \param productId the USB Product ID
+     * \return the model, or \c 0 if not supported
+     */
+    static const UsbScaleModel* find(const quint16 vendorId, const quint16 productId);
+
+    //! Get the model used when the scale is not known, the BF 480 USB.
+    static const UsbScaleModel* getDefault();
+};
+
+/*!
+ * \class BSM::Usb::UsbScaleParser
+ * \brief Decoder of the memory image of the scale into a UsbScaleData.
+ *
+ * The image can be decoded at once with decode() or while it is downloaded
+ * with feed(): each user block is decoded as soon as it is complete, the
+ * users are completed with the extra and the pointer blocks and the date
+ * and the time of the scale come last.
+ */
+class UsbScaleParser
+{
+    Q_DISABLE_COPY(UsbScaleParser)
+
+public:
+    //! Parts of the data completed by a feed.
+    enum Stage {
+        NoStage         = 0x00,     //!< Nothing new was completed
+        UserBlocks      = 0x01,     //!< At least a user block was decoded
+        Users           = 0x02,     //!< The parameters and the samples of all the users are available
+        Completed       = 0x04      //!< The date and the time of the scale are available
+    };
+
+    /*! Constructor of the class.
+     * \param target the structure to fill, owned by the caller
+     * \param model the model of the scale, \c 0 for the default one
+     */
+    explicit UsbScaleParser(UsbScaleData* target, const UsbScaleModel* model = 0);
+
+    //! Get the model of the scale.
+    const UsbScaleModel* getModel() const;
+
+    /*! Set the model of the scale, the parser is reset.
+     * \param model the model of the scale, \c 0 for the default one
+     */
+    void setModel(const UsbScaleModel* model);
+
+    /*! Set the cursors of the last download.
+     *
+     * Only the samples written after the cursors are kept: the blocks decoded
+     * before the pointers are received are trimmed when the pointers arrive.
+     * \param cursors the cursors by user ID (starting from 1), owned by the caller; \c 0 to decode all the samples
+     */
+    void setCursors(const Data::SampleCursor* cursors);
+
+    /*! Set the image of the last download of the scale.
+     *
+     * Only the users whose block, extra data or pointer changed are decoded,
+     * the slots of the others are left empty: a user that did not step on the
+     * scale costs nothing to parse or merge. While downloading, a user block
+     * equal to the previous one is not decoded before the pointers arrive.
+     * \param previous the image, of imageSize() bytes, owned by the caller; \c 0 to decode all the users
+     */
+    void setPrevious(const uchar* previous);
+
+    /*! Get the users changed since the last download.
+     * \return the users, one bit for each index in the memory of the scale
+     * \sa setPrevious
+     */
+    quint32 getChangedUsers() const;
+
+    //! Get ready for a new image.
+    void reset();
+
+    /*! Decode what is complete in the data received so far.
+     * \param data all the data received so far
+     * \param size the size in byte of the data received so far
+     * \return the combination of the Stage values completed by this call
+     */
+    int feed(const uchar* data, const int size);
+
+    //! Check if the whole image was decoded.
+    bool isCompleted() const;
+
+    //! Get the size in byte of the memory image of the scale.
+    int imageSize() const;
+
+    /*! Decode a whole image.
+     * \param data the memory image of the scale
+     * \param size the size in byte of the image
+     * \param target the structure to fill
+     * \param model the model of the scale, \c 0 for the default one
+     * \return \c true if the image was decoded, \c false if the size is wrong
+     */
+    static bool decode(const uchar* data, const int size, UsbScaleData* target, const UsbScaleModel* model = 0);
+
+private:
+    const UsbScaleModel*    m_model;
+    UsbScaleParserState     m_state;
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBSCALEDATA_HPP
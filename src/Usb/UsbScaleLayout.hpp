@@ -0,0 +1,110 @@
+/*!
+ * \file UsbScaleLayout.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the memory layouts of the scale models
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBSCALELAYOUT_HPP
+#define USBSCALELAYOUT_HPP
+
+#include <QtCore/QtGlobal>
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \struct BSM::Usb::UsbLayoutBF480
+ * \brief Memory layout of the Beurer BF 480 USB.
+ *
+ * A model is described by a structure with the same members: the sizes of the
+ * blocks in the memory image and the gaps between them. The offsets are then
+ * computed by UsbScaleLayout.
+ */
+struct UsbLayoutBF480
+{
+    enum {
+        VendorId        = 0x04d9,   //!< USB Vendor ID
+        ProductId       = 0x8010,   //!< USB Product ID
+
+        NumUsers        = 10,       //!< Number of users in the scale memory
+        NumUserVars     = 6,        //!< Number of variables saved for each user
+        NumSamples      = 60,       //!< Number of samples in each variable
+        SampleLen       = 2,        //!< Size in byte of each sample
+        SeparatorLen    = 8,        //!< Size in byte of the variables separator (all with value 0)
+
+        WeightVar       = 0,        //!< Index of the weight variable
+        BodyFatVar      = 1,        //!< Index of the body fat variable
+        WaterVar        = 2,        //!< Index of the water variable
+        MuscleVar       = 3,        //!< Index of the muscle variable
+        DateVar         = 4,        //!< Index of the date variable
+        TimeVar         = 5,        //!< Index of the time variable
+
+        ExtraBlockLen   = 512,      //!< Size in byte of the last block
+        ExtraBlockGap   = 256,      //!< Size in byte of the offset in the last block
+        ExtraUserLen    = 8,        //!< Size in byte of each user block in the extra block
+        PtrBlockGap     = 16,       //!< Size in byte between the user blocks in the extra block and the ptr block
+        ScaleDateGap    = 480,      //!< Size in byte of the offset of the scale date in the last block
+        ScaleTimeGap    = 483,      //!< Size in byte of the offset of the scale time in the last block
+        ScaleTimeLen    = 2         //!< Size in byte of the scale time (hours and minutes)
+    };
+};
+
+/*!
+ * \struct BSM::Usb::UsbScaleLayout
+ * \brief Offsets in the memory image of a scale model.
+ *
+ * All the values are compile-time constants, so the parser instantiated for
+ * a model has the same code as one with the values written by hand.
+ * \tparam Model the description of the model, like UsbLayoutBF480
+ */
+template<class Model>
+struct UsbScaleLayout : public Model
+{
+    enum {
+        //! Size in byte of a variable
+        VarLen          = Model::NumSamples * Model::SampleLen + Model::SeparatorLen,
+        //! Size in byte of an user block
+        UserLen         = Model::NumUserVars * VarLen,
+        //! Offset in byte of the extra block
+        ExtraBlockOff   = Model::NumUsers * UserLen + Model::ExtraBlockGap,
+        //! Offset in byte of the ptr block
+        PtrBlockOff     = ExtraBlockOff + Model::NumUsers * Model::ExtraUserLen + Model::PtrBlockGap,
+        //! Offset in byte of the scale date
+        ScaleDateOff    = Model::NumUsers * UserLen + Model::ScaleDateGap,
+        //! Offset in byte of the scale time
+        ScaleTimeOff    = Model::NumUsers * UserLen + Model::ScaleTimeGap,
+        //! Expected length in byte for all data
+        ExpectedLen     = Model::NumUsers * UserLen + Model::ExtraBlockLen
+    };
+};
+
+/*!
+ * \struct BSM::Usb::UsbLayoutCheck
+ * \brief Compile-time check of a layout: only the \c true case is defined.
+ */
+template<bool> struct UsbLayoutCheck;
+/*! \cond PRIVATE */
+template<> struct UsbLayoutCheck<true> {};
+/*! \endcond */
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBSCALELAYOUT_HPP
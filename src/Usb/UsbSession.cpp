@@ -0,0 +1,327 @@
+/*!
+ * \file UsbSession.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbSession class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbSession.hpp"
+
+#include <string.h>
+
+#include <QtCore/QDebug>
+#include <QtCore/QByteArray>
+
+namespace BSM {
+namespace Usb {
+
+UsbSession::UsbSession(libusb_context* ctx, libusb_device* dev)
+    : m_ctx(ctx)
+    , m_dev(libusb_ref_device(dev))
+    , m_id(deviceId(dev))
+    , m_handle(0)
+    , m_claimed(false)
+    , m_transferSend(0)
+    , m_depth(0)
+    , m_next(0)
+    , m_pending(0)
+    , m_completed(false)
+    , m_failed(false)
+    , m_size(0)
+#ifndef QT_NO_DEBUG_OUTPUT
+    , m_traceCount(0)
+#endif
+{
+    for (int i = 0; i < USB_MAX_QUEUE_DEPTH; ++i) {
+        m_transfersReceive[i].session = this;
+        m_transfersReceive[i].transfer = 0;
+        m_transfersReceive[i].done = false;
+        m_transfersReceive[i].status = 0;
+        m_transfersReceive[i].length = 0;
+    }
+}
+
+UsbSession::~UsbSession()
+{
+    close();
+    libusb_unref_device(m_dev);
+}
+
+QString UsbSession::deviceId(libusb_device* dev)
+{
+    QString id = QString::number(libusb_get_bus_number(dev));
+    uint8_t ports[7];
+    int n = libusb_get_port_numbers(dev, ports, sizeof(ports));
+    for (int i = 0; i < n; ++i)
+        id += QString((i == 0) ? "-%1" : ".%1").arg(ports[i]);
+    return id;
+}
+
+QString UsbSession::getId() const
+{
+    return m_id;
+}
+
+libusb_device* UsbSession::getDevice() const
+{
+    return m_dev;
+}
+
+bool UsbSession::open()
+{
+    if (m_handle)
+        return true;
+
+    int r;
+
+    // Open USB device
+    r = libusb_open(m_dev, &m_handle);
+    if (r < 0) {
+        qCritical() << "Failed to open the device" << m_id << r;
+        m_handle = 0;
+        return false;
+    }
+    qDebug() << "USB device" << m_id << "opened";
+
+    // Detach kernel driver
+    if (libusb_kernel_driver_active(m_handle, USB_INTERFACE_IN)) {
+        qDebug() << "Detaching kernel driver...";
+        r = libusb_detach_kernel_driver(m_handle, USB_INTERFACE_IN);
+        if (r < 0) {
+            qCritical() << "libusb_detach_kernel_driver error" << r;
+            close();
+            return false;
+        }
+        qDebug() << "Kernel driver detached";
+    }
+
+    // Claim interface
+    qDebug() << "Claiming interface...";
+    r = libusb_claim_interface(m_handle, USB_INTERFACE_IN);
+    if (r < 0) {
+        qCritical() << "usb_claim_interface error" << r;
+        close();
+        return false;
+    }
+    m_claimed = true;
+    qDebug() << "Interface claimed";
+
+    // The control request never changes: prepare it once for the whole session
+    m_transferSend = libusb_alloc_transfer(0);
+    if (!m_transferSend) {
+        close();
+        return false;
+    }
+    libusb_fill_control_setup(m_bufferSend, LIBUSB_ENDPOINT_OUT | LIBUSB_REQUEST_TYPE_CLASS | LIBUSB_RECIPIENT_INTERFACE, USB_CTRL_REQUEST, USB_CTRL_VALUE, 0, USB_CTRL_DATA_LEN);
+    m_bufferSend[LIBUSB_CONTROL_SETUP_SIZE] = USB_CTRL_DATA_FIRST;
+    memset(m_bufferSend + LIBUSB_CONTROL_SETUP_SIZE + 1, 0, USB_CTRL_DATA_LEN - 1);
+    libusb_fill_control_transfer(m_transferSend, m_handle, m_bufferSend, cb_out, this, 3000);
+
+    return true;
+}
+
+bool UsbSession::isOpen() const
+{
+    return (m_handle != 0);
+}
+
+void UsbSession::close()
+{
+    cancel();
+
+    for (int i = 0; i < USB_MAX_QUEUE_DEPTH; ++i) {
+        if (m_transfersReceive[i].transfer) {
+            libusb_free_transfer(m_transfersReceive[i].transfer);
+            m_transfersReceive[i].transfer = 0;
+        }
+    }
+    if (m_transferSend) {
+        libusb_free_transfer(m_transferSend);
+        m_transferSend = 0;
+    }
+
+    // Close USB device
+    if (m_handle) {
+        if (m_claimed) {
+            libusb_release_interface(m_handle, USB_INTERFACE_IN);
+            m_claimed = false;
+            qDebug() << "Released interface";
+        }
+        libusb_close(m_handle);
+        m_handle = 0;
+        qDebug() << "Closed USB device" << m_id;
+    }
+}
+
+bool UsbSession::start(const int depth)
+{
+    if (!m_handle || m_pending > 0)
+        return false;
+
+    m_depth = qBound(1, depth, USB_MAX_QUEUE_DEPTH);
+    m_next = 0;
+    m_completed = false;
+    m_failed = false;
+    m_size = 0;
+#ifndef QT_NO_DEBUG_OUTPUT
+    m_traceCount = 0;
+#endif
+    m_clock.start();
+
+    // Prepare to receive data, keeping a queue of requests so the host has always one
+    qDebug() << "Register for interrupt data," << m_depth << "transfers";
+    for (int i = 0; i < m_depth; ++i) {
+        InTransfer* in = &m_transfersReceive[i];
+        in->done = false;
+        if (!in->transfer) {
+            in->transfer = libusb_alloc_transfer(0);
+            if (!in->transfer)
+                return false;
+            libusb_fill_interrupt_transfer(in->transfer, m_handle, LIBUSB_ENDPOINT_IN | USB_INTERFACE_OUT, in->buffer, sizeof(in->buffer), cb_in, in, 30000);
+        }
+        if (libusb_submit_transfer(in->transfer) < 0)
+            return false;
+        ++m_pending;
+    }
+
+    // Send request
+    qDebug() << "Send control request";
+    if (libusb_submit_transfer(m_transferSend) < 0)
+        return false;
+    ++m_pending;
+
+    return true;
+}
+
+void UsbSession::cancel()
+{
+    if (m_pending <= 0)
+        return;
+
+    // Wait for the pending transfers, the buffers are owned by the session
+    for (int i = 0; i < USB_MAX_QUEUE_DEPTH; ++i) {
+        if (m_transfersReceive[i].transfer)
+            libusb_cancel_transfer(m_transfersReceive[i].transfer);
+    }
+    if (m_transferSend)
+        libusb_cancel_transfer(m_transferSend);
+    while (m_pending > 0) {
+        if (libusb_handle_events_completed(m_ctx, 0) < 0)
+            break;
+    }
+}
+
+bool UsbSession::isCompleted() const
+{
+    return m_completed;
+}
+
+bool UsbSession::isFailed() const
+{
+    return m_failed;
+}
+
+int UsbSession::getSize() const
+{
+    return m_size;
+}
+
+const unsigned char* UsbSession::getData() const
+{
+    return m_data;
+}
+
+qint64 UsbSession::getElapsed() const
+{
+    return m_clock.elapsed();
+}
+
+#ifndef QT_NO_DEBUG_OUTPUT
+void UsbSession::dumpTrace() const
+{
+    unsigned first = (m_traceCount > USB_TRACE_LEN) ? m_traceCount - USB_TRACE_LEN : 0;
+    qDebug() << "[IN]" << m_id << "received" << m_traceCount << "packets, last" << m_traceCount - first << "follow";
+    for (unsigned i = first; i < m_traceCount; ++i) {
+        const TracePacket& packet = m_trace[i % USB_TRACE_LEN];
+        QByteArray buffer((const char*) packet.data, qMin(packet.length, USB_INTR_DATA_LEN));
+        qDebug() << "[IN]" << i << "status =" << packet.status << "- actual length =" << packet.length << buffer.toHex().constData();
+    }
+}
+#endif
+
+void UsbSession::cb_out(libusb_transfer* transfer)
+{
+    qDebug() << "[OUT]" << "status =" << transfer->status << "- actual length =" << transfer->actual_length;
+
+    UsbSession* session = (UsbSession*) transfer->user_data;
+    --session->m_pending;
+    if (transfer->status != LIBUSB_TRANSFER_COMPLETED && !session->m_completed)
+        session->m_failed = true;
+}
+
+void UsbSession::cb_in(libusb_transfer* transfer)
+{
+    // Called for each packet: no allocations and no debug output here
+    InTransfer* in = (InTransfer*) transfer->user_data;
+    UsbSession* session = in->session;
+    --session->m_pending;
+
+    in->done = true;
+    in->status = transfer->status;
+    in->length = transfer->actual_length;
+
+    // Append the packets in the order the transfers were submitted
+    while (!session->m_completed && !session->m_failed) {
+        InTransfer* next = &session->m_transfersReceive[session->m_next % session->m_depth];
+        if (!next->done)
+            break;
+        next->done = false;
+        ++session->m_next;
+
+        int length = qMin(next->length, USB_EXPECTED_LEN - session->m_size);
+#ifndef QT_NO_DEBUG_OUTPUT
+        TracePacket& packet = session->m_trace[session->m_traceCount++ % USB_TRACE_LEN];
+        packet.status = next->status;
+        packet.length = next->length;
+        memcpy(packet.data, next->buffer, qMin(next->length, USB_INTR_DATA_LEN));
+#endif
+
+        memcpy(session->m_data + session->m_size, next->buffer, length);
+        session->m_size += length;
+        if (session->m_size >= USB_EXPECTED_LEN) {
+            session->m_completed = true;
+            break;
+        }
+
+        if (next->status != LIBUSB_TRANSFER_COMPLETED && next->status != LIBUSB_TRANSFER_OVERFLOW) {
+            session->m_failed = true;
+            break;
+        }
+
+        // Queue the transfer again, behind the ones still in flight
+        if (libusb_submit_transfer(next->transfer) == 0) {
+            ++session->m_pending;
+            continue;
+        }
+        session->m_failed = true;
+    }
+}
+
+} // namespace Usb
+} // namespace BSM
@@ -0,0 +1,198 @@
+/*!
+ * \file UsbSession.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbSession class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBSESSION_HPP
+#define USBSESSION_HPP
+
+#include <QtCore/QString>
+#include <QtCore/QElapsedTimer>
+
+#include <Usb/UsbTransport.hpp>
+
+#include <libusb.h>
+
+//! USB interface number for control transfer
+#define USB_INTERFACE_IN    0x00
+//! USB interface number for interrupt transfer
+#define USB_INTERFACE_OUT   0x01
+//! USB interrupt data length
+#define USB_INTR_DATA_LEN   8
+//! USB control bRequest - HID set report
+#define USB_CTRL_REQUEST    0x09
+//! USB control wValue
+#define USB_CTRL_VALUE      0x0300
+//! USB control data length
+#define USB_CTRL_DATA_LEN   8
+//! USB control data first byte value (others are 0x00)
+#define USB_CTRL_DATA_FIRST 0x10
+
+#ifndef QT_NO_DEBUG_OUTPUT
+//! Number of interrupt packets kept for the trace (debug)
+#define USB_TRACE_LEN       32
+#endif
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \class BSM::Usb::UsbSession
+ * \brief Open connection to a scale.
+ *
+ * The session keeps the device handle, the claimed interface and the pool of
+ * libusb transfers of a scale alive between downloads, so back-to-back downloads
+ * don't open the device and allocate the transfers again.
+ *
+ * The transfers are handled by the libusb event loop of the context: the owner
+ * of the session must handle the events until isCompleted() or isFailed().
+ * The session is closed when destroyed, e.g. when the scale is unplugged.
+ */
+class UsbSession
+{
+    Q_DISABLE_COPY(UsbSession)
+
+public:
+    /*! Constructor of the class.
+     * \param ctx the libusb context
+     * \param dev the libusb device of the scale, referenced by the session
+     */
+    UsbSession(libusb_context* ctx, libusb_device* dev);
+    ~UsbSession();
+
+    /*! Build the identifier of a device from its bus number and port path.
+     * \param dev the libusb device
+     * \return the identifier, like \c "1-4.2"
+     */
+    static QString deviceId(libusb_device* dev);
+
+    //! Get the identifier of the scale. \sa deviceId
+    QString getId() const;
+
+    //! Get the libusb device of the scale.
+    libusb_device* getDevice() const;
+
+    /*! Open the device, detach the kernel driver and claim the interface.
+     *
+     * Nothing is done if the session is already open.
+     * \return \c true on success or \c false on failure
+     */
+    bool open();
+
+    //! Check if the session is open.
+    bool isOpen() const;
+
+    //! Cancel the transfers, release the interface and close the device.
+    void close();
+
+    /*! Start a download.
+     *
+     * The interrupt transfers are submitted before the control request; the
+     * transfers missing in the pool are allocated.
+     * \param depth the number of interrupt transfers in flight
+     * \return \c true on success or \c false on failure
+     */
+    bool start(const int depth);
+
+    /*! Cancel the transfers still in flight and wait for them.
+     *
+     * The session stays open and can be started again.
+     */
+    void cancel();
+
+    //! Check if the download is completed.
+    bool isCompleted() const;
+
+    //! Check if the download failed.
+    bool isFailed() const;
+
+    //! Get the size in byte of the data received.
+    int getSize() const;
+
+    //! Get the data received.
+    const unsigned char* getData() const;
+
+    //! Get the time in ms since the start of the download.
+    qint64 getElapsed() const;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    //! Print the last interrupt packets received.
+    void dumpTrace() const;
+#endif
+
+private:
+    //! \private
+    struct InTransfer {
+        UsbSession* session;
+        libusb_transfer* transfer;
+        bool done;
+        int status;
+        int length;
+        unsigned char buffer[USB_INTR_DATA_LEN];
+    };
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    //! \private
+    struct TracePacket {
+        int status;
+        int length;
+        unsigned char data[USB_INTR_DATA_LEN];
+    };
+#endif
+
+    /*! Callback for the USB control transfer.
+     * \param transfer the pointer to the the control transfer
+     */
+    static void cb_out(libusb_transfer* transfer);
+    /*! Callback for the USB interrupt transfer.
+     * \param transfer the pointer to the the interrupt transfer
+     */
+    static void cb_in(libusb_transfer* transfer);
+
+    libusb_context*         m_ctx;
+    libusb_device*          m_dev;
+    QString                 m_id;
+    libusb_device_handle*   m_handle;
+    bool                    m_claimed;
+
+    libusb_transfer*        m_transferSend;
+    unsigned char           m_bufferSend[LIBUSB_CONTROL_SETUP_SIZE + USB_CTRL_DATA_LEN] __attribute__ ((aligned (2)));
+    InTransfer              m_transfersReceive[USB_MAX_QUEUE_DEPTH];
+    int                     m_depth;
+    unsigned                m_next;
+    int                     m_pending;
+
+    bool                    m_completed;
+    bool                    m_failed;
+    int                     m_size;
+    unsigned char           m_data[USB_EXPECTED_LEN];
+    QElapsedTimer           m_clock;
+
+#ifndef QT_NO_DEBUG_OUTPUT
+    TracePacket             m_trace[USB_TRACE_LEN];
+    unsigned                m_traceCount;
+#endif
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBSESSION_HPP
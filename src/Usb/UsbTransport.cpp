@@ -0,0 +1,56 @@
+/*!
+ * \file UsbTransport.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Implementation for the UsbTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "UsbTransport.hpp"
+
+namespace BSM {
+namespace Usb {
+
+UsbTransport::UsbTransport()
+{
+}
+
+UsbTransport::~UsbTransport()
+{
+}
+
+bool UsbTransport::hasHotplug() const
+{
+    return false;
+}
+
+bool UsbTransport::waitForScales()
+{
+    return false;
+}
+
+void UsbTransport::clearPending()
+{
+}
+
+void UsbTransport::wakeUp()
+{
+}
+
+} // namespace Usb
+} // namespace BSM
@@ -0,0 +1,141 @@
+/*!
+ * \file UsbTransport.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Header for the UsbTransport class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef USBTRANSPORT_HPP
+#define USBTRANSPORT_HPP
+
+#include <QtCore/QString>
+
+//! Size in byte of the memory image of a scale
+#define USB_EXPECTED_LEN    8192
+//! Maximum number of interrupt transfers in flight for each scale
+#define USB_MAX_QUEUE_DEPTH 32
+
+namespace BSM {
+namespace Usb {
+
+/*!
+ * \class BSM::Usb::UsbTransport
+ * \brief Source of the data downloaded from the scales.
+ *
+ * The UsbDownloader gets the memory images of the scales through a transport:
+ * UsbDeviceTransport talks to the real scales with libusb, UsbCaptureTransport
+ * records what another transport downloads and UsbReplayTransport plays back
+ * a recorded file.
+ *
+ * All the methods, except wakeUp(), are called from the thread of the
+ * UsbDownloader.
+ */
+class UsbTransport
+{
+    Q_DISABLE_COPY(UsbTransport)
+
+public:
+    /*!
+     * \class BSM::Usb::UsbTransport::Listener
+     * \brief Receiver of the events of a download.
+     *
+     * Each scale is identified by a string, the bus/port path for the real scales.
+     * The data pointers are valid only during the call.
+     */
+    class Listener
+    {
+    public:
+        virtual ~Listener() {}
+
+        /*! The download from a scale is started.
+         * \param device the identifier of the scale
+         */
+        virtual void transportStarted(const QString& device) = 0;
+
+        /*! Some data were received from a scale.
+         * \param device the identifier of the scale
+         * \param data all the data received so far
+         * \param size the size in byte of the data received so far
+         */
+        virtual void transportReceived(const QString& device, const unsigned char* data, const int size) = 0;
+
+        /*! The download from a scale was completed.
+         * \param device the identifier of the scale
+         * \param data the data downloaded
+         * \param size the size in byte of the data
+         */
+        virtual void transportCompleted(const QString& device, const unsigned char* data, const int size) = 0;
+
+        /*! The download from a scale cannot be completed.
+         * \param device the identifier of the scale
+         */
+        virtual void transportError(const QString& device) = 0;
+    };
+
+    //! Constructor of the class.
+    UsbTransport();
+    virtual ~UsbTransport();
+
+    //! Get a description of the transport, for the logs.
+    virtual QString getName() const = 0;
+
+    /*! Download the data from the scales.
+     *
+     * After waitForScales() returned \c true, only the scales plugged in are
+     * downloaded; otherwise all the scales connected are.
+     * \param allDevices \c true to download all the scales, \c false for the first one only
+     * \param queueDepth the number of interrupt transfers in flight for each scale
+     * \param listener the receiver of the events of the download
+     * \return \c true if at least a scale was downloaded, \c false otherwise
+     */
+    virtual bool download(const bool allDevices, const int queueDepth, Listener* listener) = 0;
+
+    /*! Check if the transport can report the scales plugged in.
+     * \return \c false, the default implementation has no hotplug support
+     * \sa waitForScales
+     */
+    virtual bool hasHotplug() const;
+
+    /*! Wait for something to happen on the bus.
+     *
+     * The call blocks until an event is received or wakeUp() is called.
+     * \return \c true if a scale was plugged in and is ready for a download, \c false otherwise
+     * \sa hasHotplug wakeUp download
+     */
+    virtual bool waitForScales();
+
+    /*! Forget the scales plugged in and not downloaded yet.
+     *
+     * It is called after a download requested by the user, so the scales
+     * plugged in meanwhile are not downloaded again.
+     * \sa waitForScales
+     */
+    virtual void clearPending();
+
+    /*! Wake up a thread blocked in waitForScales() or download().
+     *
+     * This method can be called from any thread.
+     */
+    virtual void wakeUp();
+};
+
+} // namespace Usb
+} // namespace BSM
+
+#endif // USBTRANSPORT_HPP
@@ -28,25 +28,150 @@
 #include <QtCore/QLocale>
 #include <QtCore/QLibraryInfo>
 #include <QtCore/QDir>
+#include <QtCore/QSettings>
+#include <QtCore/QHash>
+#include <QtCore/QSet>
+#include <QtCore/QStringList>
+#include <QtCore/QThreadStorage>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QMutex>
+#include <QtCore/QMutexLocker>
 
 #include <QtGui/QApplication>
 #include <QtGui/QMessageBox>
+#include <QtGui/QProgressDialog>
 
 #include <QtSql/QSqlQuery>
-#include <QtSql/QSqlRecord>
 
 #include <config.hpp>
 
 // For the createTable functions
 #include <Data/UserDataDB.hpp>
+#include <Data/UserMeasurementDB.hpp>
+#include <Data/MeasurementRollupDB.hpp>
+#include <Data/RawImageDB.hpp>
+#include <Data/SchemaMigrator.hpp>
 
 //! Table name for version table
 #define VERSION_TABLE_NAME "TablesVersions"
 
+//! Maximum number of prepared queries kept for each connection
+#define QUERY_CACHE_SIZE            32
+
+//! Name of the configuration file, in the saving directory
+#define CONFIG_FILE_NAME            "BeurerScaleManager.ini"
+
+// Default performance profile of the DB
+//! Journal mode: WAL lets the readers work while a download is written
+#define DB_DEFAULT_JOURNAL_MODE     "WAL"
+//! Synchronous mode: with WAL, NORMAL syncs only at the checkpoints
+#define DB_DEFAULT_SYNCHRONOUS      "NORMAL"
+//! Size in byte of the memory mapped I/O
+#define DB_DEFAULT_MMAP_SIZE        (64 * 1024 * 1024)
+//! Size of the page cache: negative in KiB, positive in pages
+#define DB_DEFAULT_CACHE_SIZE       (-8192)
+//! Storage of the temporary tables and indices
+#define DB_DEFAULT_TEMP_STORE       "MEMORY"
+//! Size in byte of the pages, used only when the DB is created
+#define DB_DEFAULT_PAGE_SIZE        4096
+
 namespace BSM {
 namespace Utils {
 
-QSqlDatabase db;
+//! Path of the DB, set when it is opened
+static QString databasePath;
+
+//! Number of the connections opened, for their names
+static QAtomicInt connectionCount;
+
+/*!
+ * \brief Prepared queries of a connection.
+ *
+ * The queries are keyed by their SQL text; when the cache is full the least
+ * recently used one is discarded.
+ */
+struct QueryCache
+{
+    QHash<QString, QSqlQuery>   queries;    //!< The prepared queries by SQL text
+    QList<QString>              recent;     //!< The SQL texts, the most recently used first
+};
+
+/*!
+ * \brief Connections to the DB of a thread.
+ *
+ * Deleted when the thread ends: the queries are finalized before their
+ * connections are closed and removed.
+ */
+struct ThreadConnections
+{
+    QSqlDatabase                connections[ReadOnly + 1];  //!< The connections by ConnectionMode, not valid until opened
+    QHash<QString, QueryCache>  queryCaches;                //!< The prepared queries by connection name
+
+    ~ThreadConnections()
+    {
+        queryCaches.clear();
+        for (int mode = ReadWrite; mode <= ReadOnly; ++mode) {
+            if (!connections[mode].isValid())
+                continue;
+            QString name = connections[mode].connectionName();
+            connections[mode].close();
+            connections[mode] = QSqlDatabase();
+            QSqlDatabase::removeDatabase(name);
+        }
+    }
+};
+
+//! The connections of each thread
+static QThreadStorage<ThreadConnections*> threadConnections;
+
+//! Get the connections of the current thread.
+static ThreadConnections& localConnections()
+{
+    if (!threadConnections.hasLocalData())
+        threadConnections.setLocalData(new ThreadConnections());
+    return *threadConnections.localData();
+}
+
+/*!
+ * \brief Tables of the DB and their versions.
+ *
+ * Loaded once when the DB is opened and kept updated by createTable(),
+ * dropTable() and setTableVersion(), so checking the schema needs no query.
+ * The catalog is shared by all the threads, like the DB: it is guarded by
+ * schemaMutex.
+ */
+struct SchemaCatalog
+{
+    QSet<QString>       tables;     //!< The names of the tables
+    QHash<QString, int> versions;   //!< The versions of the tables, as in the version table
+};
+
+//! The schema of the DB
+static SchemaCatalog schemaCatalog;
+
+//! Mutex for schemaCatalog
+static QMutex schemaMutex;
+
+bool loadSchemaCatalog()
+{
+    QSet<QString> tables = database().tables().toSet();
+    QHash<QString, int> versions;
+
+    if (tables.contains(VERSION_TABLE_NAME)) {
+        QSqlQuery query;
+        if (!prepareQuery(query, "SELECT tableName, version FROM " VERSION_TABLE_NAME ";") || !query.exec()) {
+            qCritical() << "Cannot load the versions of the tables";
+            return false;
+        }
+        while (query.next())
+            versions.insert(query.value(0).toString(), query.value(1).toInt());
+    }
+
+    QMutexLocker locker(&schemaMutex);
+    schemaCatalog.tables = tables;
+    schemaCatalog.versions = versions;
+    return true;
+}
 
 void loadTranslation()
 {
@@ -121,40 +246,213 @@ QString getSavingDirectory()
     return QDir::homePath() + "/" BSM_SAVING_FOLDER "/";
 }
 
-bool openDdAndCheckTables()
+QString getConfigFile()
 {
-    // DB path
-    QString dbPath = getSavingDirectory() + "BeurerScaleManager.db";
-    qDebug() << "DB in" << dbPath;
+    return getSavingDirectory() + CONFIG_FILE_NAME;
+}
+
+/*! Read a value of the configuration, saving the default one if missing.
+ *
+ * The defaults are written so the file shows all the values that can be set.
+ * \param settings the configuration
+ * \param key the key of the value
+ * \param defaultValue the default value
+ * \return the value
+ */
+static QVariant configValue(QSettings& settings, const QString& key, const QVariant& defaultValue)
+{
+    if (!settings.contains(key))
+        settings.setValue(key, defaultValue);
+    return settings.value(key, defaultValue);
+}
+
+/*! Read a keyword of the configuration.
+ * \param settings the configuration
+ * \param key the key of the value
+ * \param allowed the allowed keywords, the first one is the default
+ * \return the keyword, in upper case
+ */
+static QString configKeyword(QSettings& settings, const QString& key, const QStringList& allowed)
+{
+    QString value = configValue(settings, key, allowed.first()).toString().toUpper();
+    if (!allowed.contains(value)) {
+        qWarning() << "Invalid value" << value << "for" << key << ", using" << allowed.first();
+        return allowed.first();
+    }
+    return value;
+}
+
+/*! Read an integer of the configuration.
+ * \param settings the configuration
+ * \param key the key of the value
+ * \param defaultValue the default value
+ * \return the value
+ */
+static qint64 configInteger(QSettings& settings, const QString& key, const qint64 defaultValue)
+{
+    bool ok;
+    qint64 value = configValue(settings, key, defaultValue).toLongLong(&ok);
+    if (!ok) {
+        qWarning() << "Invalid value for" << key << ", using" << defaultValue;
+        return defaultValue;
+    }
+    return value;
+}
 
-    // Open DB
-    db = QSqlDatabase::addDatabase("QSQLITE");
-    db.setDatabaseName(dbPath);
-    if (!db.open()) {
+bool getDownloadAllDevices()
+{
+    QSettings settings(getConfigFile(), QSettings::IniFormat);
+    settings.beginGroup("Usb");
+    bool allDevices = configValue(settings, "allDevices", true).toBool();
+    settings.endGroup();
+    return allDevices;
+}
+
+/*! Apply the performance profile of the configuration file to a connection.
+ *
+ * The page size can be changed only before the first table is created, so it
+ * is set only on a new DB and before the journal mode. The journal mode and
+ * the synchronous mode are set only by the ReadWrite connections.
+ * \param connection the connection
+ * \param mode the kind of the connection
+ * \return \c true on success or \c false on failure
+ */
+static bool applyDbProfile(QSqlDatabase connection, const ConnectionMode mode)
+{
+    QSettings settings(getConfigFile(), QSettings::IniFormat);
+    settings.beginGroup("Database");
+    QString journalMode = configKeyword(settings, "journalMode", QStringList() << DB_DEFAULT_JOURNAL_MODE << "DELETE" << "TRUNCATE" << "PERSIST" << "MEMORY" << "OFF");
+    QString synchronous = configKeyword(settings, "synchronous", QStringList() << DB_DEFAULT_SYNCHRONOUS << "OFF" << "FULL" << "EXTRA");
+    QString tempStore = configKeyword(settings, "tempStore", QStringList() << DB_DEFAULT_TEMP_STORE << "DEFAULT" << "FILE");
+    qint64 mmapSize = configInteger(settings, "mmapSize", DB_DEFAULT_MMAP_SIZE);
+    qint64 cacheSize = configInteger(settings, "cacheSize", DB_DEFAULT_CACHE_SIZE);
+    qint64 pageSize = configInteger(settings, "pageSize", DB_DEFAULT_PAGE_SIZE);
+    settings.endGroup();
+    qDebug() << "DB profile of" << connection.connectionName() << ":" << journalMode << synchronous << tempStore << mmapSize << cacheSize << pageSize;
+
+    QSqlQuery query(connection);
+
+    if (mode == ReadWrite) {
+        // Page size, for a new DB
+        if (query.exec("PRAGMA page_count;") && query.next() && query.value(0).toLongLong() == 0) {
+            if (!query.exec("PRAGMA page_size = " + QString::number(pageSize) + ";"))
+                qWarning() << "Cannot set the page size of the DB";
+        }
+
+        // Journal mode, SQLite returns the mode in use
+        if (!query.exec("PRAGMA journal_mode = " + journalMode + ";") || !query.next()) {
+            qCritical() << "Cannot set the journal mode of the DB";
+            return false;
+        }
+        if (query.value(0).toString().toUpper() != journalMode)
+            qWarning() << "The journal mode of the DB is" << query.value(0).toString() << "instead of" << journalMode;
+        query.finish();
+
+        if (!query.exec("PRAGMA synchronous = " + synchronous + ";")) {
+            qCritical() << "Cannot set the synchronous mode of the DB";
+            return false;
+        }
+    }
+
+    if (!query.exec("PRAGMA temp_store = " + tempStore + ";") ||
+        !query.exec("PRAGMA mmap_size = " + QString::number(mmapSize) + ";") ||
+        !query.exec("PRAGMA cache_size = " + QString::number(cacheSize) + ";")
+    ) {
+        qCritical() << "Cannot set the profile of the DB";
+        return false;
+    }
+    query.finish();
+
+    return true;
+}
+
+/*! Open a connection to the DB for the current thread.
+ * \param mode the kind of connection
+ * \return the connection, not valid on failure
+ */
+static QSqlDatabase openConnection(const ConnectionMode mode)
+{
+    QString name = QString("BSM-%1-%2").arg(mode == ReadOnly ? "ro" : "rw").arg(connectionCount.fetchAndAddRelaxed(1));
+    {
+        QSqlDatabase connection = QSqlDatabase::addDatabase("QSQLITE", name);
+        connection.setDatabaseName(databasePath);
+        if (mode == ReadOnly)
+            connection.setConnectOptions("QSQLITE_OPEN_READONLY");
+        if (connection.open()) {
+            if (!applyDbProfile(connection, mode))
+                qWarning() << "Using the default profile for the connection" << name;
+            qDebug() << "Opened the connection" << name;
+            return connection;
+        }
+        qCritical() << "Cannot open the connection" << name;
+    }
+    QSqlDatabase::removeDatabase(name);
+    return QSqlDatabase();
+}
+
+bool openDb(const QString& path)
+{
+    // Open DB, with the connection of the current thread; the performance profile
+    // is read from the configuration file
+    releaseConnections();
+    databasePath = path;
+    if (!database().isValid()) {
         qCritical() << "Cannot open DB";
-        QMessageBox::critical(0,
-                              "Beurer Scale Manager - " + qApp->translate("BSM::Utils", "Database not opened"),
-                              qApp->translate("BSM::Utils", "Cannot open the database \"%1\".<br><br>Please check your environment.").arg(dbPath)
-        );
         return false;
     }
 
     // Create version table, if doesn't exists
     if (!executeQuery("CREATE TABLE IF NOT EXISTS " VERSION_TABLE_NAME " (tableName TEXT PRIMARY KEY, version INTEGER) WITHOUT ROWID;")) {
         qCritical() << "Cannot create version table";
+        return false;
+    }
+
+    // Schema of the DB, for the checks of the tables
+    return loadSchemaCatalog();
+}
+
+bool openDdAndCheckTables()
+{
+    // DB path
+    QString dbPath = getSavingDirectory() + "BeurerScaleManager.db";
+    qDebug() << "DB in" << dbPath;
+
+    if (!openDb(dbPath)) {
         QMessageBox::critical(0,
-                              "Beurer Scale Manager - " + qApp->translate("BSM::Utils", "Cannot create table"),
-                              qApp->translate("BSM::Utils", "Cannot create table \"%1\".<br><br>Please check your environment.").arg(VERSION_TABLE_NAME)
+                              "Beurer Scale Manager - " + qApp->translate("BSM::Utils", "Database not opened"),
+                              qApp->translate("BSM::Utils", "Cannot open the database \"%1\".<br><br>Please check your environment.").arg(dbPath)
         );
         return false;
     }
 
-    // Check or create tables for objects
+    // Check, update or create tables for objects; long updates are shown
+    Data::SchemaMigrator migrator;
+    QProgressDialog progress;
+    progress.setWindowTitle("Beurer Scale Manager - " + qApp->translate("BSM::Utils", "Updating the database"));
+    progress.setWindowModality(Qt::ApplicationModal);
+    progress.setCancelButton(0);
+    QObject::connect(&migrator, SIGNAL(started(QString)), &progress, SLOT(setLabelText(QString)));
+    QObject::connect(&migrator, SIGNAL(progress(int)), &progress, SLOT(setValue(int)));
+
     QStringList failedTables;
-    if (!Data::UserDataDB::createTable()) {
+    if (!Data::UserDataDB::createTable(migrator)) {
         qCritical() << "Cannot create table" << Data::UserDataDB::tableName;
         failedTables << Data::UserDataDB::tableName;
     }
+    if (!Data::UserMeasurementDB::createTable(migrator)) {
+        qCritical() << "Cannot create table" << Data::UserMeasurementDB::tableName;
+        failedTables << Data::UserMeasurementDB::tableName;
+    }
+    if (!Data::MeasurementRollupDB::createTable(migrator)) {
+        qCritical() << "Cannot create table" << Data::MeasurementRollupDB::tableName;
+        failedTables << Data::MeasurementRollupDB::tableName;
+    }
+    if (!Data::RawImageDB::createTable(migrator)) {
+        qCritical() << "Cannot create table" << Data::RawImageDB::tableName;
+        failedTables << Data::RawImageDB::tableName;
+    }
+    progress.reset();
+
     // Check for errors
     if (!failedTables.isEmpty()) {
         QMessageBox::critical(0,
@@ -167,26 +465,51 @@ bool openDdAndCheckTables()
     return true;
 }
 
+QSqlDatabase database(const ConnectionMode mode)
+{
+    if (databasePath.isEmpty()) {
+        qCritical() << "The DB is not opened";
+        return QSqlDatabase();
+    }
+
+    QSqlDatabase& connection = localConnections().connections[mode];
+    if (!connection.isValid())
+        connection = openConnection(mode);
+    return connection;
+}
+
+void releaseConnections()
+{
+    threadConnections.setLocalData(0);
+}
+
 void closeDb()
 {
-    db.close();
+    // The statements are finalized before closing
+    releaseConnections();
 }
 
 bool isTablePresent(const QString& tableName)
 {
-    return (db.tables().indexOf(tableName) >= 0);
+    QMutexLocker locker(&schemaMutex);
+    return schemaCatalog.tables.contains(tableName);
 }
 
-bool createTable(const QString& tableName, const ColumnList& tableDefinition)
+bool createTable(const QString& tableName, const ColumnList& tableDefinition, const bool withoutRowid)
 {
     QStringList tmp;
     ColumnList::ConstIterator it, itEnd = tableDefinition.end();
     for (it = tableDefinition.begin(); it != itEnd; ++it)
         tmp << it->first + " " + it->second;
 
-    QString sql = QString("CREATE TABLE `%1` (%2) WITHOUT ROWID;").arg(tableName).arg(tmp.join(", "));
+    QString sql = QString("CREATE TABLE `%1` (%2)%3;").arg(tableName).arg(tmp.join(", ")).arg(withoutRowid ? " WITHOUT ROWID" : "");
     qDebug() << "Creating table" << tableName << ":" << sql;
-    return executeQuery(sql);
+    if (!executeQuery(sql))
+        return false;
+
+    QMutexLocker locker(&schemaMutex);
+    schemaCatalog.tables.insert(tableName);
+    return true;
 }
 
 bool dropTable(const QString& tableName)
@@ -194,15 +517,29 @@ bool dropTable(const QString& tableName)
     if (!isTablePresent(tableName))
         return true;
 
-    QSqlQuery query(db);
-
-    if (executeQuery("DROP TABLE " + tableName + ";"))
+    if (executeQuery("DROP TABLE " + tableName + ";")) {
+        QMutexLocker locker(&schemaMutex);
+        schemaCatalog.tables.remove(tableName);
         return true;
+    }
 
     qWarning() << "Cannot drop table" << tableName;
     return false;
 }
 
+bool renameTable(const QString& tableName, const QString& newName)
+{
+    if (executeQuery("ALTER TABLE " + tableName + " RENAME TO " + newName + ";")) {
+        QMutexLocker locker(&schemaMutex);
+        schemaCatalog.tables.remove(tableName);
+        schemaCatalog.tables.insert(newName);
+        return true;
+    }
+
+    qWarning() << "Cannot rename table" << tableName << "to" << newName;
+    return false;
+}
+
 int getTableVersion(const QString& tableName)
 {
     if (!isTablePresent(VERSION_TABLE_NAME))
@@ -210,25 +547,17 @@ int getTableVersion(const QString& tableName)
     if (!isTablePresent(tableName))
         return 0;
 
-    QSqlQuery query(db);
+    // The versions are read from the catalog, loaded with the cached query of loadSchemaCatalog()
+    QMutexLocker locker(&schemaMutex);
+    QHash<QString, int>::ConstIterator it = schemaCatalog.versions.find(tableName);
+    if (it != schemaCatalog.versions.end())
+        return *it;
+    locker.unlock();
 
-    if (query.prepare("SELECT version FROM " VERSION_TABLE_NAME " WHERE tableName = :tableName;")) {
-        query.bindValue(":tableName", tableName);
-        if (query.exec()) {
-            if (query.next()) {
-                QVariant version = query.record().value("version");
-                if (version.isValid()) {
-                    bool ok;
-                    int retval = version.toUInt(&ok);
-                    if (ok)
-                        return retval;
-                }
-            }
-        }
-    }
+    // A table without a version was created, but its version was not saved
 
     qWarning() << "Cannot find version for table" << tableName;
-    return -1;
+    return 0;
 }
 
 bool setTableVersion(const QString& tableName, const int tableVersion)
@@ -238,12 +567,13 @@ bool setTableVersion(const QString& tableName, const int tableVersion)
     if (!isTablePresent(tableName))
         return false;
 
-    QSqlQuery query(db);
-
-    if (query.prepare("INSERT OR REPLACE INTO TablesVersions (tableName, version) VALUES (:tableName, :version);")) {
+    QSqlQuery query;
+    if (prepareQuery(query, "INSERT OR REPLACE INTO " VERSION_TABLE_NAME " (tableName, version) VALUES (:tableName, :version);")) {
         query.bindValue(":tableName", QVariant(tableName));
         query.bindValue(":version", tableVersion);
         if (query.exec()) {
+            QMutexLocker locker(&schemaMutex);
+            schemaCatalog.versions.insert(tableName, tableVersion);
             return true;
         }
     }
@@ -254,15 +584,47 @@ bool setTableVersion(const QString& tableName, const int tableVersion)
 
 bool executeQuery(QString sql)
 {
-    QSqlQuery query(db);
-
-    if (!query.prepare(sql))
+    QSqlQuery query;
+    if (!prepareQuery(query, sql))
         return false;
-    if (!query.exec())
+
+    // No rows are read: the statement is reset, so it does not lock the tables
+    bool success = query.exec();
+    query.finish();
+    return success;
+}
+
+bool prepareQuery(QSqlQuery& query, const QString& sql, QSqlDatabase connection)
+{
+    QueryCache& cache = localConnections().queryCaches[connection.connectionName()];
+
+    QHash<QString, QSqlQuery>::iterator it = cache.queries.find(sql);
+    if (it != cache.queries.end()) {
+        cache.recent.removeOne(sql);
+        cache.recent.prepend(sql);
+        query = *it;
+        return true;
+    }
+
+    // The rows are read only once, Qt does not need to keep them
+    QSqlQuery prepared(connection);
+    prepared.setForwardOnly(true);
+    if (!prepared.prepare(sql))
         return false;
 
+    cache.queries.insert(sql, prepared);
+    cache.recent.prepend(sql);
+    if (cache.recent.size() > QUERY_CACHE_SIZE)
+        cache.queries.remove(cache.recent.takeLast());
+
+    query = prepared;
     return true;
 }
 
+void clearQueryCache(QSqlDatabase connection)
+{
+    localConnections().queryCaches.remove(connection.connectionName());
+}
+
 } // namespace Utils
 } // namespace BSM
@@ -29,12 +29,39 @@
 #include <QtCore/QPair>
 
 #include <QtSql/QSqlDatabase>
+#include <QtSql/QSqlQuery>
 
 namespace BSM {
 namespace Utils {
 
-//! Instance of the DB.
-extern QSqlDatabase db;
+/*! Kind of connection to the DB.
+ * \sa database
+ */
+enum ConnectionMode {
+    ReadWrite,      //!< Connection for the writes and the changes of the schema
+    ReadOnly        //!< Connection for the queries, it never takes the write lock
+};
+
+/*! Get a connection to the DB for the current thread.
+ *
+ * Qt allows to use a connection only in the thread that created it, so each
+ * thread has its own connections: they are opened at the first use, with the
+ * performance profile of the configuration file, and closed when the thread
+ * ends or calls releaseConnections().
+ *
+ * With the WAL journal the ReadOnly connections of any number of threads
+ * read a snapshot of the DB while a single writer (the Data::DbWorker)
+ * commits, so the readers are not blocked by the downloads.
+ * \param mode the kind of connection
+ * \return the connection, not valid if the DB is not opened
+ */
+QSqlDatabase database(const ConnectionMode mode = ReadWrite);
+
+/*! Close the connections of the current thread.
+ *
+ * The prepared queries of the connections are discarded.
+ */
+void releaseConnections();
 
 //! Load the translation for the current language.
 void loadTranslation();
@@ -45,34 +72,94 @@ bool checkUserDirectory();
 //! Retrieve the user folder for saving.
 QString getSavingDirectory();
 
+/*! Retrieve the configuration file, in the user folder for saving.
+ *
+ * The \c Database group holds the performance profile of the DB:
+ * \c journalMode, \c synchronous, \c tempStore, \c mmapSize, \c cacheSize and
+ * \c pageSize, as the SQLite pragmas with the same names. The \c Usb group
+ * holds \c allDevices, to download all the connected scales instead of the
+ * first one found.
+ */
+QString getConfigFile();
+
+/*! Check if all the connected scales must be downloaded, from the configuration file.
+ * \return \c true to download all the scales, the default, or \c false for the first one only
+ */
+bool getDownloadAllDevices();
+
+/*! Open a DB, with the version table and the schema catalog.
+ *
+ * The tables of the objects are not checked, see openDdAndCheckTables().
+ * \param path the path of the DB file
+ * \return \c true on success or \c false on failure
+ */
+bool openDb(const QString& path);
+
 //! Open the DB and check for tables.
 bool openDdAndCheckTables();
 
-//! Close the DB.
+//! Close the DB, with the connections of the current thread.
 void closeDb();
 
-//! Check for table presence
+//! Check for table presence, in the schema loaded when the DB was opened
 bool isTablePresent (const QString& tableName);
 //! Column definition type
 typedef QPair<QString, QString> Column;
 //! Column list type
 typedef QList<Column> ColumnList;
-//! Create a table
-bool createTable(const QString& tableName, const ColumnList& tableDefinition);
+/*! Create a table.
+ * \param tableName the name of the table
+ * \param tableDefinition the columns and the constraints of the table
+ * \param withoutRowid \c true to store the rows in the primary key, for the tables with a small composite key
+ * \return \c true on success or \c false on failure
+ */
+bool createTable(const QString& tableName, const ColumnList& tableDefinition, const bool withoutRowid = false);
 //! Drop a table
 bool dropTable(const QString& tableName);
+//! Rename a table
+bool renameTable(const QString& tableName, const QString& newName);
+//! Load again the schema of the DB, after it was changed without these functions.
+bool loadSchemaCatalog();
 
-//! Get the version of the table.
+/*! Get the version of the table.
+ *
+ * The version is read from the schema loaded when the DB was opened, so it
+ * costs no query.
+ * \return the version, \c 0 if the table or its version are not present, \c -1 if the version table is not present
+ */
 int getTableVersion(const QString& tableName);
 //! Set the version of the table.
 bool setTableVersion(const QString& tableName, const int tableVersion);
 
 /*! Execute query on the DB.
+ *
+ * The query is prepared through prepareQuery(), so the statements executed
+ * again, like the savepoints, are not parsed again. The rows of the result,
+ * if any, are discarded.
  * \param sql the SQL query
  * \return \c true on success or \c false on failure
  */
 bool executeQuery(QString sql);
 
+/*! Get a prepared query from the cache of a connection.
+ *
+ * The queries are kept prepared by SQL text, so executing the same SQL again
+ * costs only the binding of the values. The queries are forward-only.
+ * The query is shared with the cache: all the values must be bound before
+ * each execution, and a query not read to the end must be finished with
+ * QSqlQuery::finish().
+ * \param query the query to set
+ * \param sql the SQL query
+ * \param connection the connection, the one of the thread by default
+ * \return \c true on success or \c false if the SQL cannot be prepared
+ */
+bool prepareQuery(QSqlQuery& query, const QString& sql, QSqlDatabase connection = database());
+
+/*! Discard the prepared queries of a connection, in the current thread.
+ * \param connection the connection, the one of the thread by default
+ */
+void clearQueryCache(QSqlDatabase connection = database());
+
 } // namespace Utils
 } // namespace BSM
 
@@ -0,0 +1,87 @@
+/*!
+ * \file TestDatabase.hpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Helpers for the tests that use the DB
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef TESTDATABASE_HPP
+#define TESTDATABASE_HPP
+
+#include <utils.hpp>
+#include <config.hpp>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+
+namespace BSM {
+namespace Tests {
+
+/*! Use a new directory as the home of the user.
+ *
+ * The configuration file is written in the home directory: the tests must
+ * not touch the one of the user.
+ * \return the path of the directory, empty on failure
+ */
+inline QString setUpHome()
+{
+    QString home = QDir::temp().filePath("bsm-test-" + QString::number(QCoreApplication::applicationPid()));
+    if (!QDir().mkpath(home + "/" BSM_SAVING_FOLDER))
+        return QString();
+    qputenv("HOME", QFile::encodeName(home));
+    return home;
+}
+
+/*! Open an empty DB in the home of the tests.
+ * \param home the home of the tests, from setUpHome()
+ * \return \c true on success or \c false on failure
+ */
+inline bool openEmptyDb(const QString& home)
+{
+    Utils::closeDb();
+    QString path = home + "/test.db";
+    foreach (const QString& suffix, QStringList() << "" << "-wal" << "-shm") {
+        if (QFile::exists(path + suffix) && !QFile::remove(path + suffix))
+            return false;
+    }
+    return Utils::openDb(path);
+}
+
+/*! Remove the home of the tests.
+ * \param home the home of the tests, from setUpHome()
+ */
+inline void tearDownHome(const QString& home)
+{
+    Utils::closeDb();
+    QDir dir(home);
+    foreach (const QString& name, dir.entryList(QDir::Files))
+        dir.remove(name);
+    QDir config(home + "/" BSM_SAVING_FOLDER);
+    foreach (const QString& name, config.entryList(QDir::Files))
+        config.remove(name);
+    dir.rmdir(BSM_SAVING_FOLDER);
+    QDir::temp().rmdir(dir.dirName());
+}
+
+} // namespace Tests
+} // namespace BSM
+
+#endif // TESTDATABASE_HPP
@@ -0,0 +1,205 @@
+/*!
+ * \file TestDbWorker.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Tests for the DbWorker class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestDatabase.hpp"
+
+#include <Data/DbWorker.hpp>
+
+#include <QtTest/QtTest>
+#include <QtSql/QSqlQuery>
+
+using namespace BSM;
+
+//! Name of the table written by the tests
+#define TEST_TABLE  "Job"
+//! Time in ms left to the worker to write a batch too early
+#define TEST_SETTLE 50
+
+/*!
+ * \class TestDbWorker
+ * \brief Tests for the DbWorker class.
+ */
+class TestDbWorker : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void coalesceBatch();
+    void nestedBatch();
+    void rollbackBatch();
+    void writeOnStop();
+    void writeWithoutWorker();
+
+private:
+    //! Get a job that inserts a row.
+    static Data::DbJob insertJob(const int id);
+    //! Get the number of rows of the table.
+    static int countRows();
+    //! Stop a worker and wait for the thread.
+    static void stopWorker(Data::DbWorker* worker);
+
+    QString m_home;
+};
+
+void TestDbWorker::initTestCase()
+{
+    m_home = Tests::setUpHome();
+    QVERIFY(!m_home.isEmpty());
+}
+
+void TestDbWorker::init()
+{
+    QVERIFY(Tests::openEmptyDb(m_home));
+    QVERIFY(Utils::executeQuery("CREATE TABLE " TEST_TABLE " (id INTEGER PRIMARY KEY);"));
+}
+
+void TestDbWorker::cleanupTestCase()
+{
+    Tests::tearDownHome(m_home);
+}
+
+Data::DbJob TestDbWorker::insertJob(const int id)
+{
+    Data::DbJob job("TestDbWorker::insertJob()", "INSERT INTO " TEST_TABLE " (id) VALUES (:id);");
+    job.bindValue(":id", id);
+    return job;
+}
+
+int TestDbWorker::countRows()
+{
+    QSqlQuery query(Utils::database());
+    if (!query.exec("SELECT COUNT(*) FROM " TEST_TABLE ";") || !query.next())
+        return -1;
+    return query.value(0).toInt();
+}
+
+void TestDbWorker::stopWorker(Data::DbWorker* worker)
+{
+    worker->stop();
+    QVERIFY(worker->wait(5000));
+}
+
+void TestDbWorker::coalesceBatch()
+{
+    Data::DbWorker worker;
+    QSignalSpy written(&worker, SIGNAL(written(int)));
+    QSignalSpy failed(&worker, SIGNAL(failed(int)));
+    worker.start();
+
+    // The jobs of a batch are written in one transaction
+    QVERIFY(Data::DbWorker::beginBatch());
+    for (int id = 1; id <= 3; ++id)
+        QVERIFY(Data::DbWorker::submit(insertJob(id)));
+    QVERIFY(Data::DbWorker::endBatch());
+    stopWorker(&worker);
+
+    QCOMPARE(failed.count(), 0);
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(written.at(0).at(0).toInt(), 3);
+    QCOMPARE(countRows(), 3);
+}
+
+void TestDbWorker::nestedBatch()
+{
+    Data::DbWorker worker;
+    QSignalSpy written(&worker, SIGNAL(written(int)));
+    worker.start();
+
+    // Only the outer batch writes the jobs
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(1)));
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(2)));
+    QVERIFY(Data::DbWorker::endBatch());
+    QTest::qSleep(TEST_SETTLE);
+    QCOMPARE(written.count(), 0);
+    QVERIFY(Data::DbWorker::submit(insertJob(3)));
+    QVERIFY(Data::DbWorker::endBatch());
+    stopWorker(&worker);
+
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(written.at(0).at(0).toInt(), 3);
+    QCOMPARE(countRows(), 3);
+}
+
+void TestDbWorker::rollbackBatch()
+{
+    Data::DbWorker worker;
+    QSignalSpy written(&worker, SIGNAL(written(int)));
+    QSignalSpy failed(&worker, SIGNAL(failed(int)));
+    worker.start();
+
+    // The second insert violates the key: the first one is rolled back too
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(1)));
+    QVERIFY(Data::DbWorker::submit(insertJob(1)));
+    QVERIFY(Data::DbWorker::endBatch());
+    stopWorker(&worker);
+
+    QCOMPARE(written.count(), 0);
+    QCOMPARE(failed.count(), 1);
+    QCOMPARE(failed.at(0).at(0).toInt(), 2);
+    QCOMPARE(countRows(), 0);
+}
+
+void TestDbWorker::writeOnStop()
+{
+    Data::DbWorker worker;
+    QSignalSpy written(&worker, SIGNAL(written(int)));
+    worker.start();
+
+    // A batch still open is written when the worker stops
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(1)));
+    QVERIFY(Data::DbWorker::submit(insertJob(2)));
+    stopWorker(&worker);
+    QVERIFY(Data::DbWorker::endBatch());
+
+    QCOMPARE(written.count(), 1);
+    QCOMPARE(written.at(0).at(0).toInt(), 2);
+    QCOMPARE(countRows(), 2);
+}
+
+void TestDbWorker::writeWithoutWorker()
+{
+    QVERIFY(!Data::DbWorker::getInstance());
+
+    // The jobs are executed by the caller, in its transaction
+    QVERIFY(Data::DbWorker::submit(insertJob(1)));
+    QCOMPARE(countRows(), 1);
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::beginBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(2)));
+    QVERIFY(Data::DbWorker::endBatch());
+    QVERIFY(Data::DbWorker::submit(insertJob(3)));
+    QVERIFY(Data::DbWorker::endBatch());
+    QCOMPARE(countRows(), 3);
+    QVERIFY(!Data::DbWorker::endBatch());
+}
+
+QTEST_MAIN(TestDbWorker)
+#include "TestDbWorker.moc"
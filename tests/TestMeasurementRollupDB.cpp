@@ -0,0 +1,246 @@
+/*!
+ * \file TestMeasurementRollupDB.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Tests for the MeasurementRollupDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestDatabase.hpp"
+
+#include <Data/MeasurementRollupDB.hpp>
+#include <Data/UserMeasurementDB.hpp>
+#include <Data/SchemaMigrator.hpp>
+#include <Data/Models/MeasurementRollupModel.hpp>
+
+#include <QtTest/QtTest>
+#include <QtCore/QMap>
+
+using namespace BSM;
+
+//! ID of the user of the tests
+#define TEST_USER   1
+
+/*!
+ * \class TestMeasurementRollupDB
+ * \brief Tests for the MeasurementRollupDB class.
+ *
+ * The measurements are at the edges of the days, of the weeks and of the
+ * months, before and after the epoch: the periods computed by SQLite must
+ * be the ones of MeasurementRollupDB::bucketOf().
+ */
+class TestMeasurementRollupDB : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void bucketOf();
+    void rebuildRollups();
+    void updateRollups();
+    void loadRange();
+    void rollupModel();
+
+private:
+    //! Get the measurements of the tests, from the oldest one.
+    static Data::UserMeasurementList measurements();
+    //! Check the rollups of all the resolutions against bucketOf().
+    static void checkRollups(const Data::UserMeasurementList& measurements);
+    //! Get the timestamp of a local date and time.
+    static Data::Timestamp timestamp(const int year, const int month, const int day, const int hour = 0, const int minute = 0);
+
+    QString m_home;
+};
+
+void TestMeasurementRollupDB::initTestCase()
+{
+    m_home = Tests::setUpHome();
+    QVERIFY(!m_home.isEmpty());
+}
+
+void TestMeasurementRollupDB::init()
+{
+    QVERIFY(Tests::openEmptyDb(m_home));
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::UserMeasurementDB::createTable(migrator));
+}
+
+void TestMeasurementRollupDB::cleanupTestCase()
+{
+    Tests::tearDownHome(m_home);
+}
+
+Data::Timestamp TestMeasurementRollupDB::timestamp(const int year, const int month, const int day, const int hour, const int minute)
+{
+    return Data::Timestamp::fromDateTime(QDateTime(QDate(year, month, day), QTime(hour, minute)));
+}
+
+Data::UserMeasurementList TestMeasurementRollupDB::measurements()
+{
+    QList<Data::Timestamp> timestamps;
+    timestamps << timestamp(1969, 12, 28, 23, 59)  // Sunday, before the epoch
+               << timestamp(1969, 12, 29, 10, 0)   // Monday of the week of the epoch
+               << timestamp(1970, 1, 1)            // Thursday, the epoch
+               << timestamp(1970, 1, 4, 23, 59)    // Sunday
+               << timestamp(2023, 12, 31, 12, 0)   // Sunday, end of a year
+               << timestamp(2024, 1, 1, 8, 0)      // Monday, start of a year
+               << timestamp(2024, 2, 29, 23, 59)   // Thursday, leap day
+               << timestamp(2024, 3, 1)            // Friday, same week
+               << timestamp(2024, 3, 3, 23, 59)    // Sunday
+               << timestamp(2024, 3, 4)            // Monday
+               << timestamp(2024, 3, 4, 18, 30);   // Same day
+
+    Data::UserMeasurementList list;
+    for (int i = 0; i < timestamps.size(); ++i) {
+        Data::UserMeasurement* m = new Data::UserMeasurement();
+        m->setTimestamp(timestamps.at(i));
+        m->setWeight(70.0 + i * 0.5);
+        m->setBodyFatPercent(20.0 + i * 0.1);
+        m->setWaterPercent(55.0 - i * 0.1);
+        m->setMusclePercent(35.0 + i * 0.2);
+        list << m;
+    }
+    return list;
+}
+
+void TestMeasurementRollupDB::checkRollups(const Data::UserMeasurementList& measurements)
+{
+    for (int r = Data::MeasurementRollupDB::Day; r <= Data::MeasurementRollupDB::Year; ++r) {
+        Data::MeasurementRollupDB::Resolution resolution = Data::MeasurementRollupDB::Resolution(r);
+
+        // The periods of the measurements, with their count and the sum and the range of the weights
+        QMap<qint64, Data::MeasurementRollup> expected;
+        foreach (const Data::UserMeasurement* m, measurements) {
+            int weight = qRound(m->getWeight() * 10);
+            qint64 bucket = Data::MeasurementRollupDB::bucketOf(resolution, m->getTimestamp()).toMinutes();
+            if (!expected.contains(bucket)) {
+                Data::MeasurementRollup rollup;
+                rollup.bucket = bucket;
+                rollup.count = 0;
+                rollup.weight.sum = 0;
+                rollup.weight.min = weight;
+                rollup.weight.max = weight;
+                expected.insert(bucket, rollup);
+            }
+            Data::MeasurementRollup& rollup = expected[bucket];
+            ++rollup.count;
+            rollup.weight.sum += weight;
+            rollup.weight.min = qMin(rollup.weight.min, weight);
+            rollup.weight.max = qMax(rollup.weight.max, weight);
+        }
+
+        Data::MeasurementRollupList rollups;
+        QVERIFY(Data::MeasurementRollupDB::load(TEST_USER, resolution, Data::Timestamp(), Data::Timestamp(), rollups));
+        QCOMPARE(rollups.size(), expected.size());
+        QMap<qint64, Data::MeasurementRollup>::const_iterator it = expected.constBegin();
+        for (int i = 0; i < rollups.size(); ++i, ++it) {
+            QCOMPARE(rollups.at(i).bucket, it.key());
+            QCOMPARE(rollups.at(i).count, it->count);
+            QCOMPARE(rollups.at(i).weight.sum, it->weight.sum);
+            QCOMPARE(rollups.at(i).weight.min, it->weight.min);
+            QCOMPARE(rollups.at(i).weight.max, it->weight.max);
+        }
+    }
+}
+
+void TestMeasurementRollupDB::bucketOf()
+{
+    typedef Data::MeasurementRollupDB DB;
+    QCOMPARE(DB::bucketOf(DB::Day, timestamp(2024, 3, 4, 18, 30)), timestamp(2024, 3, 4));
+    QCOMPARE(DB::bucketOf(DB::Week, timestamp(2024, 3, 3, 23, 59)), timestamp(2024, 2, 26));
+    QCOMPARE(DB::bucketOf(DB::Week, timestamp(2024, 3, 4)), timestamp(2024, 3, 4));
+    QCOMPARE(DB::bucketOf(DB::Week, timestamp(1970, 1, 1)), timestamp(1969, 12, 29));
+    QCOMPARE(DB::bucketOf(DB::Month, timestamp(2024, 2, 29, 23, 59)), timestamp(2024, 2, 1));
+    QCOMPARE(DB::bucketOf(DB::Quarter, timestamp(2024, 3, 31)), timestamp(2024, 1, 1));
+    QCOMPARE(DB::bucketOf(DB::Quarter, timestamp(2024, 4, 1)), timestamp(2024, 4, 1));
+    QCOMPARE(DB::bucketOf(DB::Year, timestamp(1969, 12, 28, 23, 59)), timestamp(1969, 1, 1));
+}
+
+void TestMeasurementRollupDB::rebuildRollups()
+{
+    // A new table is filled from the measurements already saved
+    Data::UserMeasurementList list = measurements();
+    QVERIFY(Data::UserMeasurementDB::insert(TEST_USER, list));
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::MeasurementRollupDB::createTable(migrator));
+
+    checkRollups(list);
+    qDeleteAll(list);
+}
+
+void TestMeasurementRollupDB::updateRollups()
+{
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::MeasurementRollupDB::createTable(migrator));
+
+    // Two downloads: the second one adds to the periods of the first one
+    Data::UserMeasurementList list = measurements();
+    Data::UserMeasurementList first, second;
+    for (int i = 0; i < list.size(); ++i)
+        (i % 2 == 0 ? first : second) << list.at(i);
+    QVERIFY(Data::UserMeasurementDB::insert(TEST_USER, first));
+    QVERIFY(Data::MeasurementRollupDB::update(TEST_USER, first));
+    checkRollups(first);
+    QVERIFY(Data::UserMeasurementDB::insert(TEST_USER, second));
+    QVERIFY(Data::MeasurementRollupDB::update(TEST_USER, second));
+
+    checkRollups(list);
+    qDeleteAll(list);
+}
+
+void TestMeasurementRollupDB::loadRange()
+{
+    Data::UserMeasurementList list = measurements();
+    QVERIFY(Data::UserMeasurementDB::insert(TEST_USER, list));
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::MeasurementRollupDB::createTable(migrator));
+    qDeleteAll(list);
+
+    // The range starts from the period of the first timestamp, the last one is excluded
+    Data::MeasurementRollupList rollups;
+    QVERIFY(Data::MeasurementRollupDB::load(TEST_USER, Data::MeasurementRollupDB::Month, timestamp(2024, 1, 15), timestamp(2024, 3, 1), rollups));
+    QCOMPARE(rollups.size(), 2);
+    QCOMPARE(rollups.at(0).bucket, timestamp(2024, 1, 1).toMinutes());
+    QCOMPARE(rollups.at(0).count, 1);
+    QCOMPARE(rollups.at(1).bucket, timestamp(2024, 2, 1).toMinutes());
+    QCOMPARE(rollups.at(1).count, 1);
+}
+
+void TestMeasurementRollupDB::rollupModel()
+{
+    Data::UserMeasurementList list = measurements();
+    QVERIFY(Data::UserMeasurementDB::insert(TEST_USER, list));
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::MeasurementRollupDB::createTable(migrator));
+    qDeleteAll(list);
+
+    // The periods are shown from the newest one, with the averages
+    Data::Models::MeasurementRollupModel model(TEST_USER, Data::MeasurementRollupDB::Year, Data::Timestamp(), Data::Timestamp());
+    QCOMPARE(model.rowCount(), 4);
+    QCOMPARE(model.getRollup(0).bucket, timestamp(2024, 1, 1).toMinutes());
+    QCOMPARE(model.getRollup(0).count, 6);
+    QCOMPARE(model.getRollup(3).bucket, timestamp(1969, 1, 1).toMinutes());
+    QCOMPARE(model.getRollup(3).count, 2);
+    QCOMPARE(model.getRollup(3).average(model.getRollup(3).weight), 70.25);
+}
+
+QTEST_MAIN(TestMeasurementRollupDB)
+#include "TestMeasurementRollupDB.moc"
@@ -0,0 +1,219 @@
+/*!
+ * \file TestSchemaMigrator.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Tests for the SchemaMigrator class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestDatabase.hpp"
+
+#include <Data/SchemaMigrator.hpp>
+
+#include <QtTest/QtTest>
+#include <QtSql/QSqlQuery>
+
+using namespace BSM;
+
+//! Name of the table updated by the tests
+#define TEST_TABLE  "Sample"
+//! Number of rows of the table
+#define TEST_ROWS   12
+//! Number of rows copied in each savepoint
+#define TEST_BATCH  5
+
+/*!
+ * \class TestSchemaMigrator
+ * \brief Tests for the SchemaMigrator class.
+ */
+class TestSchemaMigrator : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void createTable();
+    void adoptTable();
+    void rejectNewerTable();
+    void copyRows();
+    void resumeCopy();
+
+private:
+    //! Create the table at version 1, with TEST_ROWS rows.
+    void createSample();
+    //! Get a step that copies the rows into the version 2, with a new column.
+    static Data::SchemaMigrator::Step copyStep(const QString& doubleValue);
+    //! Check the table at version 2.
+    void checkCopy();
+    //! Get the progress emitted, in order.
+    static QList<int> progressValues(const QSignalSpy& spy);
+
+    QString m_home;
+};
+
+void TestSchemaMigrator::initTestCase()
+{
+    m_home = Tests::setUpHome();
+    QVERIFY(!m_home.isEmpty());
+}
+
+void TestSchemaMigrator::init()
+{
+    QVERIFY(Tests::openEmptyDb(m_home));
+}
+
+void TestSchemaMigrator::cleanupTestCase()
+{
+    Tests::tearDownHome(m_home);
+}
+
+void TestSchemaMigrator::createSample()
+{
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("id", "INTEGER PRIMARY KEY"));
+    columns.append(Utils::Column("value", "INTEGER NOT NULL"));
+    Data::SchemaMigrator migrator;
+    QVERIFY(migrator.migrate(TEST_TABLE, columns, 1, Data::SchemaMigrator::StepList()));
+
+    for (int id = 1; id <= TEST_ROWS; ++id)
+        QVERIFY(Utils::executeQuery(QString("INSERT INTO " TEST_TABLE " (id, value) VALUES (%1, %2);").arg(id).arg(id * 10)));
+}
+
+Data::SchemaMigrator::Step TestSchemaMigrator::copyStep(const QString& doubleValue)
+{
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("id", "INTEGER PRIMARY KEY"));
+    columns.append(Utils::Column("value", "INTEGER NOT NULL"));
+    columns.append(Utils::Column("doubleValue", "INTEGER NOT NULL"));
+    return Data::SchemaMigrator::Step(2, columns, QStringList() << "id", QStringList() << "id" << "value" << doubleValue);
+}
+
+void TestSchemaMigrator::checkCopy()
+{
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 2);
+    QVERIFY(!Utils::isTablePresent(TEST_TABLE "_v2"));
+
+    QSqlQuery query(Utils::database());
+    QVERIFY(query.exec("SELECT id, value, doubleValue FROM " TEST_TABLE " ORDER BY id;"));
+    int rows = 0;
+    while (query.next()) {
+        ++rows;
+        QCOMPARE(query.value(0).toInt(), rows);
+        QCOMPARE(query.value(1).toInt(), rows * 10);
+        QCOMPARE(query.value(2).toInt(), rows * 20);
+    }
+    QCOMPARE(rows, TEST_ROWS);
+
+    // The state of a completed copy is deleted
+    QVERIFY(query.exec("SELECT COUNT(*) FROM MigrationState;"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 0);
+}
+
+QList<int> TestSchemaMigrator::progressValues(const QSignalSpy& spy)
+{
+    QList<int> values;
+    for (int i = 0; i < spy.count(); ++i)
+        values << spy.at(i).at(0).toInt();
+    return values;
+}
+
+void TestSchemaMigrator::createTable()
+{
+    createSample();
+    QVERIFY(Utils::isTablePresent(TEST_TABLE));
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 1);
+}
+
+void TestSchemaMigrator::adoptTable()
+{
+    // A table created without saving its version
+    QVERIFY(Utils::executeQuery("CREATE TABLE " TEST_TABLE " (id INTEGER PRIMARY KEY, value INTEGER NOT NULL);"));
+    QVERIFY(Utils::executeQuery("INSERT INTO " TEST_TABLE " (id, value) VALUES (1, 10);"));
+    QVERIFY(Utils::loadSchemaCatalog());
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 0);
+
+    Utils::ColumnList columns;
+    columns.append(Utils::Column("id", "INTEGER PRIMARY KEY"));
+    columns.append(Utils::Column("value", "INTEGER NOT NULL"));
+    Data::SchemaMigrator migrator;
+    QVERIFY(migrator.migrate(TEST_TABLE, columns, 1, Data::SchemaMigrator::StepList()));
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 1);
+
+    QSqlQuery query(Utils::database());
+    QVERIFY(query.exec("SELECT COUNT(*) FROM " TEST_TABLE ";"));
+    QVERIFY(query.next());
+    QCOMPARE(query.value(0).toInt(), 1);
+}
+
+void TestSchemaMigrator::rejectNewerTable()
+{
+    createSample();
+    QVERIFY(Utils::setTableVersion(TEST_TABLE, 3));
+
+    Data::SchemaMigrator migrator;
+    Data::SchemaMigrator::StepList steps;
+    steps.append(copyStep("value * 2"));
+    QVERIFY(!migrator.migrate(TEST_TABLE, Utils::ColumnList(), 2, steps));
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 3);
+}
+
+void TestSchemaMigrator::copyRows()
+{
+    createSample();
+
+    Data::SchemaMigrator migrator;
+    migrator.setBatchSize(TEST_BATCH);
+    QSignalSpy spy(&migrator, SIGNAL(progress(int)));
+    Data::SchemaMigrator::StepList steps;
+    steps.append(copyStep("value * 2"));
+    QVERIFY(migrator.migrate(TEST_TABLE, copyStep("value * 2").columns, 2, steps));
+    checkCopy();
+
+    // One progress after each batch of 5 rows out of 12
+    QCOMPARE(progressValues(spy), QList<int>() << 0 << 41 << 83 << 99 << 100);
+}
+
+void TestSchemaMigrator::resumeCopy()
+{
+    createSample();
+
+    // The second batch fails, at the first row after the batch size: the
+    // expression overflows
+    Data::SchemaMigrator migrator;
+    migrator.setBatchSize(TEST_BATCH);
+    Data::SchemaMigrator::StepList failing;
+    failing.append(copyStep(QString("CASE WHEN id > %1 THEN abs(-9223372036854775807 - 1) ELSE value * 2 END").arg(TEST_BATCH)));
+    QVERIFY(!migrator.migrate(TEST_TABLE, failing.first().columns, 2, failing));
+    QCOMPARE(Utils::getTableVersion(TEST_TABLE), 1);
+    QVERIFY(Utils::isTablePresent(TEST_TABLE "_v2"));
+
+    // The copy goes on from the second batch
+    QSignalSpy spy(&migrator, SIGNAL(progress(int)));
+    Data::SchemaMigrator::StepList steps;
+    steps.append(copyStep("value * 2"));
+    QVERIFY(migrator.migrate(TEST_TABLE, steps.first().columns, 2, steps));
+    checkCopy();
+    QCOMPARE(progressValues(spy), QList<int>() << 0 << 83 << 99 << 100);
+}
+
+QTEST_MAIN(TestSchemaMigrator)
+#include "TestSchemaMigrator.moc"
@@ -0,0 +1,361 @@
+/*!
+ * \file TestUsbScaleParser.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Tests for the UsbScaleParser class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Usb/UsbScaleData.hpp>
+#include <Usb/UsbScaleLayout.hpp>
+
+#include <QtTest/QtTest>
+#include <QtCore/QByteArray>
+
+using namespace BSM;
+
+//! The layout of the images built by the tests
+typedef Usb::UsbScaleLayout<Usb::UsbLayoutBF480> Layout;
+
+//! Size in byte of the chunks fed while downloading
+#define TEST_CHUNK  64
+
+/*!
+ * \class TestUsbScaleParser
+ * \brief Tests for the UsbScaleParser class.
+ *
+ * The images are built by the tests: user 1 has a full ring, with the
+ * pointer in the middle of the rows, and user 2 has a few samples.
+ */
+class TestUsbScaleParser : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void init();
+
+    void decodeImage();
+    void hashContent();
+    void trimAtCursor();
+    void resetCursor();
+    void diffUsers();
+    void diffGap();
+    void feedChunks();
+
+private:
+    /*! Write a sample of a user.
+     * \param index the index of the user
+     * \param slot the index of the sample in the rows
+     * \param sample the number of the sample, from the oldest one: it gives the values
+     */
+    void setSample(const int index, const int slot, const int sample);
+    /*! Write the parameters and the samples of a user.
+     * \param index the index of the user
+     * \param count the number of samples, from the oldest one
+     * \param pointer the index of the oldest sample, when the ring is full
+     */
+    void setUser(const int index, const int count, const int pointer);
+    //! Get the timestamp of a sample written by setSample().
+    static qint64 sampleMinutes(const int sample);
+    //! Get the weight of a sample written by setSample().
+    static quint16 sampleWeight(const int sample);
+    //! Get the image.
+    const uchar* image() const;
+    //! Compare two decoded users.
+    static void compareUsers(const Usb::UsbUserSamples& actual, const Usb::UsbUserSamples& expected);
+
+    QByteArray m_image;
+};
+
+void TestUsbScaleParser::init()
+{
+    m_image = QByteArray(Layout::ExpectedLen, '\0');
+    // Scale date 2020-03-15, 10:30
+    m_image[Layout::ScaleDateOff] = char(((100 << 9) | (3 << 5) | 15) >> 8);
+    m_image[Layout::ScaleDateOff + 1] = char(((100 << 9) | (3 << 5) | 15) & 0xFF);
+    m_image[Layout::ScaleTimeOff] = 10;
+    m_image[Layout::ScaleTimeOff + 1] = 30;
+
+    setUser(0, Layout::NumSamples, 20);
+    setUser(1, 5, 0);
+}
+
+void TestUsbScaleParser::setSample(const int index, const int slot, const int sample)
+{
+    uchar* block = reinterpret_cast<uchar*>(m_image.data()) + index * Layout::UserLen + slot * Layout::SampleLen;
+    quint16 values[] = { sampleWeight(sample), quint16(200 + sample), quint16(500 + sample), quint16(300 + sample) };
+    int vars[] = { Layout::WeightVar, Layout::BodyFatVar, Layout::WaterVar, Layout::MuscleVar };
+    for (int i = 0; i < 4; ++i) {
+        block[vars[i] * Layout::VarLen] = values[i] >> 8;
+        block[vars[i] * Layout::VarLen + 1] = values[i] & 0xFF;
+    }
+
+    // Two samples a day from 2020-01-01, each at a different minute
+    quint16 date = (100 << 9) | ((1 + sample / 56) << 5) | (1 + (sample / 2) % 28);
+    block[Layout::DateVar * Layout::VarLen] = date >> 8;
+    block[Layout::DateVar * Layout::VarLen + 1] = date & 0xFF;
+    block[Layout::TimeVar * Layout::VarLen] = 8 + sample % 2 * 10;
+    block[Layout::TimeVar * Layout::VarLen + 1] = sample % 60;
+}
+
+void TestUsbScaleParser::setUser(const int index, const int count, const int pointer)
+{
+    uchar* data = reinterpret_cast<uchar*>(m_image.data());
+    uchar* extra = data + Layout::ExtraBlockOff + index * Layout::ExtraUserLen;
+    extra[0] = index + 1;
+    extra[1] = 175;
+    extra[2] = 0x12;
+    extra[3] = 0x34;
+    extra[4] = 0x82;
+    extra[5] = count;
+    data[Layout::PtrBlockOff + index] = pointer;
+
+    const int first = (count == Layout::NumSamples) ? pointer : 0;
+    for (int sample = 0; sample < count; ++sample)
+        setSample(index, (first + sample) % Layout::NumSamples, sample);
+}
+
+qint64 TestUsbScaleParser::sampleMinutes(const int sample)
+{
+    quint16 date = (100 << 9) | ((1 + sample / 56) << 5) | (1 + (sample / 2) % 28);
+    return Data::Timestamp::scaleMinutes(date, 8 + sample % 2 * 10, sample % 60);
+}
+
+quint16 TestUsbScaleParser::sampleWeight(const int sample)
+{
+    return 700 + sample;
+}
+
+const uchar* TestUsbScaleParser::image() const
+{
+    return reinterpret_cast<const uchar*>(m_image.constData());
+}
+
+void TestUsbScaleParser::compareUsers(const Usb::UsbUserSamples& actual, const Usb::UsbUserSamples& expected)
+{
+    QCOMPARE(actual.id, expected.id);
+    QCOMPARE(actual.numSamples, expected.numSamples);
+    QCOMPARE(actual.partial, expected.partial);
+    // The rest of a slot not used is not cleared
+    if (!expected.id)
+        return;
+    QCOMPARE(actual.cursor.timestamp, expected.cursor.timestamp);
+    QCOMPARE(actual.cursor.count, expected.cursor.count);
+    QCOMPARE(actual.cursor.pointer, expected.cursor.pointer);
+    for (int sample = 0; sample < expected.numSamples; ++sample) {
+        QCOMPARE(actual.weight[sample], expected.weight[sample]);
+        QCOMPARE(actual.bodyFat[sample], expected.bodyFat[sample]);
+        QCOMPARE(actual.water[sample], expected.water[sample]);
+        QCOMPARE(actual.muscle[sample], expected.muscle[sample]);
+        QCOMPARE(actual.timestamp[sample], expected.timestamp[sample]);
+    }
+}
+
+void TestUsbScaleParser::decodeImage()
+{
+    Usb::UsbScaleData data;
+    QVERIFY(Usb::UsbScaleParser::decode(image(), m_image.size(), &data));
+    QVERIFY(!Usb::UsbScaleParser::decode(image(), m_image.size() - 1, &data));
+
+    // The full ring starts after the pointer
+    const Usb::UsbUserSamples& ring = data.users[0];
+    QCOMPARE(int(ring.id), 1);
+    QCOMPARE(int(ring.numSamples), int(Layout::NumSamples));
+    QCOMPARE(int(ring.partial), 0);
+    QCOMPARE(int(ring.female), 1);
+    QCOMPARE(int(ring.activity), 2);
+    for (int sample = 0; sample < Layout::NumSamples; ++sample) {
+        QCOMPARE(ring.weight[sample], sampleWeight(sample));
+        QCOMPARE(ring.timestamp[sample], sampleMinutes(sample));
+    }
+    QCOMPARE(ring.cursor.timestamp, sampleMinutes(Layout::NumSamples - 1));
+    QCOMPARE(int(ring.cursor.pointer), 20);
+
+    const Usb::UsbUserSamples& few = data.users[1];
+    QCOMPARE(int(few.id), 2);
+    QCOMPARE(int(few.numSamples), 5);
+    QCOMPARE(few.weight[4], sampleWeight(4));
+    QCOMPARE(few.cursor.timestamp, sampleMinutes(4));
+
+    QCOMPARE(int(data.users[2].id), 0);
+    QCOMPARE(data.dateTime, Data::Timestamp::scaleMinutes((100 << 9) | (3 << 5) | 15, 10, 30));
+}
+
+void TestUsbScaleParser::hashContent()
+{
+    const Usb::UsbScaleModel* model = Usb::UsbScaleModel::getDefault();
+    const quint64 hash = model->hash(image(), m_image.size());
+
+    // The date and the time of the scale are not content
+    m_image[Layout::ScaleDateOff + 1] = m_image[Layout::ScaleDateOff + 1] + 1;
+    m_image[Layout::ScaleTimeOff + 1] = 31;
+    QCOMPARE(model->hash(image(), m_image.size()), hash);
+
+    // A new sample is
+    setSample(1, 5, 5);
+    QVERIFY(model->hash(image(), m_image.size()) != hash);
+}
+
+void TestUsbScaleParser::trimAtCursor()
+{
+    Data::SampleCursor cursors[USB_MAX_USERS];
+    for (int i = 0; i < USB_MAX_USERS; ++i)
+        cursors[i].timestamp = Data::Timestamp::Invalid;
+    // Two samples were written after the last download in the full ring
+    cursors[0].timestamp = sampleMinutes(Layout::NumSamples - 3);
+    cursors[0].count = Layout::NumSamples;
+    cursors[0].pointer = 18;
+    // Three samples were written after the last download in the other one
+    cursors[1].timestamp = sampleMinutes(1);
+    cursors[1].count = 2;
+    cursors[1].pointer = 0;
+
+    Usb::UsbScaleData data;
+    Usb::UsbScaleParser parser(&data);
+    parser.setCursors(cursors);
+    parser.feed(image(), m_image.size());
+
+    const Usb::UsbUserSamples& ring = data.users[0];
+    QCOMPARE(int(ring.partial), 1);
+    QCOMPARE(int(ring.numSamples), 2);
+    QCOMPARE(ring.weight[0], sampleWeight(Layout::NumSamples - 2));
+    QCOMPARE(ring.timestamp[1], sampleMinutes(Layout::NumSamples - 1));
+    QCOMPARE(ring.cursor.timestamp, sampleMinutes(Layout::NumSamples - 1));
+
+    const Usb::UsbUserSamples& few = data.users[1];
+    QCOMPARE(int(few.partial), 1);
+    QCOMPARE(int(few.numSamples), 3);
+    QCOMPARE(few.weight[0], sampleWeight(2));
+    QCOMPARE(few.cursor.timestamp, sampleMinutes(4));
+    QCOMPARE(int(few.cursor.count), 5);
+}
+
+void TestUsbScaleParser::resetCursor()
+{
+    Data::SampleCursor cursors[USB_MAX_USERS];
+    for (int i = 0; i < USB_MAX_USERS; ++i)
+        cursors[i].timestamp = Data::Timestamp::Invalid;
+    // The sample before the new ones is not the newest one known
+    cursors[0].timestamp = sampleMinutes(Layout::NumSamples - 4);
+    cursors[0].count = Layout::NumSamples;
+    cursors[0].pointer = 18;
+    // The scale reports fewer samples than the last download
+    cursors[1].timestamp = sampleMinutes(6);
+    cursors[1].count = 7;
+    cursors[1].pointer = 0;
+
+    Usb::UsbScaleData data;
+    Usb::UsbScaleParser parser(&data);
+    parser.setCursors(cursors);
+    parser.feed(image(), m_image.size());
+
+    // All the samples are decoded
+    QCOMPARE(int(data.users[0].partial), 0);
+    QCOMPARE(int(data.users[0].numSamples), int(Layout::NumSamples));
+    QCOMPARE(data.users[0].weight[0], sampleWeight(0));
+    QCOMPARE(int(data.users[1].partial), 0);
+    QCOMPARE(int(data.users[1].numSamples), 5);
+}
+
+void TestUsbScaleParser::diffUsers()
+{
+    const QByteArray previous = m_image;
+    setUser(1, 6, 0);
+
+    Usb::UsbScaleData data;
+    Usb::UsbScaleParser parser(&data);
+    parser.setPrevious(reinterpret_cast<const uchar*>(previous.constData()));
+    parser.feed(image(), m_image.size());
+
+    // Only the user with a new sample is decoded
+    QCOMPARE(parser.getChangedUsers(), quint32(1u << 1));
+    QCOMPARE(int(data.users[0].id), 0);
+    QCOMPARE(int(data.users[1].id), 2);
+    QCOMPARE(int(data.users[1].numSamples), 6);
+
+    // A new pointer alone changes the user
+    const QByteArray current = m_image;
+    m_image[Layout::PtrBlockOff] = 21;
+    parser.setPrevious(reinterpret_cast<const uchar*>(current.constData()));
+    parser.reset();
+    parser.feed(image(), m_image.size());
+    QCOMPARE(parser.getChangedUsers(), quint32(1u << 0));
+}
+
+void TestUsbScaleParser::diffGap()
+{
+    const QByteArray previous = m_image;
+    // A byte of the extra block that belongs to no user
+    m_image[Layout::ExtraBlockOff + Layout::NumUsers * Layout::ExtraUserLen] = 1;
+
+    Usb::UsbScaleData data;
+    Usb::UsbScaleParser parser(&data);
+    parser.setPrevious(reinterpret_cast<const uchar*>(previous.constData()));
+    parser.feed(image(), m_image.size());
+    QCOMPARE(parser.getChangedUsers(), quint32((1u << Layout::NumUsers) - 1));
+    QCOMPARE(int(data.users[0].id), 1);
+}
+
+void TestUsbScaleParser::feedChunks()
+{
+    Data::SampleCursor cursors[USB_MAX_USERS];
+    for (int i = 0; i < USB_MAX_USERS; ++i)
+        cursors[i].timestamp = Data::Timestamp::Invalid;
+    cursors[0].timestamp = sampleMinutes(Layout::NumSamples - 3);
+    cursors[0].count = Layout::NumSamples;
+    cursors[0].pointer = 18;
+
+    // Two samples were added to the full ring, user 2 is unchanged: its
+    // block is left for the pointers
+    setUser(0, Layout::NumSamples, 18);
+    const QByteArray previous = m_image;
+    setUser(0, Layout::NumSamples, 20);
+    const uchar* previousImage = reinterpret_cast<const uchar*>(previous.constData());
+
+    Usb::UsbScaleData whole;
+    Usb::UsbScaleParser wholeParser(&whole);
+    wholeParser.setCursors(cursors);
+    wholeParser.setPrevious(previousImage);
+    QCOMPARE(wholeParser.feed(image(), m_image.size()), int(Usb::UsbScaleParser::Users | Usb::UsbScaleParser::Completed));
+
+    // The blocks are decoded as they arrive, then aligned with the pointers
+    Usb::UsbScaleData chunked;
+    Usb::UsbScaleParser chunkedParser(&chunked);
+    chunkedParser.setCursors(cursors);
+    chunkedParser.setPrevious(previousImage);
+    int stages = Usb::UsbScaleParser::NoStage;
+    int firstUsers = -1;
+    for (int size = TEST_CHUNK; !chunkedParser.isCompleted(); size += TEST_CHUNK) {
+        int fed = chunkedParser.feed(image(), qMin(size, m_image.size()));
+        if (fed & Usb::UsbScaleParser::UserBlocks && firstUsers < 0)
+            firstUsers = size;
+        stages |= fed;
+    }
+    QCOMPARE(stages, int(Usb::UsbScaleParser::UserBlocks | Usb::UsbScaleParser::Users | Usb::UsbScaleParser::Completed));
+    QVERIFY(firstUsers >= Layout::UserLen && firstUsers < Layout::UserLen + TEST_CHUNK);
+
+    QCOMPARE(chunkedParser.getChangedUsers(), wholeParser.getChangedUsers());
+    QCOMPARE(chunkedParser.getChangedUsers(), quint32(1u << 0));
+    QCOMPARE(chunked.dateTime, whole.dateTime);
+    for (int user = 0; user < Layout::NumUsers; ++user)
+        compareUsers(chunked.users[user], whole.users[user]);
+    QCOMPARE(int(chunked.users[0].partial), 1);
+}
+
+QTEST_MAIN(TestUsbScaleParser)
+#include "TestUsbScaleParser.moc"
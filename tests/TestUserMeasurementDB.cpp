@@ -0,0 +1,177 @@
+/*!
+ * \file TestUserMeasurementDB.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Tests for the UserMeasurementDB class
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestDatabase.hpp"
+
+#include <Data/UserMeasurementDB.hpp>
+#include <Data/SchemaMigrator.hpp>
+#include <Data/Models/UserMeasurementModel.hpp>
+
+#include <QtTest/QtTest>
+
+using namespace BSM;
+
+//! ID of the user of the tests
+#define TEST_USER   1
+//! ID of another user, whose measurements must never be loaded
+#define OTHER_USER  2
+
+Q_DECLARE_METATYPE(QList<qint64>)
+
+/*!
+ * \class TestUserMeasurementDB
+ * \brief Tests for the UserMeasurementDB class.
+ *
+ * The user of the tests has the measurements at 100, 200, 300 and 400
+ * minutes; the other user has one at 250 minutes.
+ */
+class TestUserMeasurementDB : public QObject
+{
+    Q_OBJECT
+
+private slots:
+    void initTestCase();
+    void init();
+    void cleanupTestCase();
+
+    void decodeValues();
+    void loadRange_data();
+    void loadRange();
+    void loadPage();
+    void rangeModel();
+
+private:
+    //! Insert a measurement.
+    static void insert(const uint userId, const qint64 minutes);
+    //! Get the timestamps of some measurements, in minutes.
+    static QList<qint64> minutes(const Data::UserMeasurementList& measurements);
+
+    QString m_home;
+};
+
+void TestUserMeasurementDB::initTestCase()
+{
+    m_home = Tests::setUpHome();
+    QVERIFY(!m_home.isEmpty());
+}
+
+void TestUserMeasurementDB::init()
+{
+    QVERIFY(Tests::openEmptyDb(m_home));
+    Data::SchemaMigrator migrator;
+    QVERIFY(Data::UserMeasurementDB::createTable(migrator));
+
+    insert(TEST_USER, 300);
+    insert(TEST_USER, 100);
+    insert(TEST_USER, 400);
+    insert(TEST_USER, 200);
+    insert(OTHER_USER, 250);
+}
+
+void TestUserMeasurementDB::cleanupTestCase()
+{
+    Tests::tearDownHome(m_home);
+}
+
+void TestUserMeasurementDB::insert(const uint userId, const qint64 minutes)
+{
+    Data::UserMeasurement measurement;
+    measurement.setTimestamp(Data::Timestamp(minutes));
+    measurement.setWeight(70.5);
+    measurement.setBodyFatPercent(20.1);
+    measurement.setWaterPercent(55.2);
+    measurement.setMusclePercent(35.3);
+    QVERIFY(Data::UserMeasurementDB::insert(userId, Data::UserMeasurementList() << &measurement));
+}
+
+QList<qint64> TestUserMeasurementDB::minutes(const Data::UserMeasurementList& measurements)
+{
+    QList<qint64> values;
+    foreach (const Data::UserMeasurement* measurement, measurements)
+        values << measurement->getTimestamp().toMinutes();
+    return values;
+}
+
+void TestUserMeasurementDB::decodeValues()
+{
+    Data::UserMeasurementList measurements;
+    QCOMPARE(Data::UserMeasurementDB::loadRange(OTHER_USER, Data::Timestamp(), Data::Timestamp(), measurements), 1);
+    QCOMPARE(measurements.first()->getTimestamp().toMinutes(), qint64(250));
+    QCOMPARE(measurements.first()->getWeight(), 70.5);
+    QCOMPARE(measurements.first()->getBodyFatPercent(), 20.1);
+    QCOMPARE(measurements.first()->getWaterPercent(), 55.2);
+    QCOMPARE(measurements.first()->getMusclePercent(), 35.3);
+    qDeleteAll(measurements);
+}
+
+void TestUserMeasurementDB::loadRange_data()
+{
+    QTest::addColumn<qint64>("from");
+    QTest::addColumn<qint64>("to");
+    QTest::addColumn< QList<qint64> >("expected");
+
+    const qint64 none = Data::Timestamp::Invalid;
+    QTest::newRow("all") << none << none << (QList<qint64>() << 100 << 200 << 300 << 400);
+    QTest::newRow("from included, to excluded") << qint64(200) << qint64(400) << (QList<qint64>() << 200 << 300);
+    QTest::newRow("to only") << none << qint64(300) << (QList<qint64>() << 100 << 200);
+    QTest::newRow("from only") << qint64(300) << none << (QList<qint64>() << 300 << 400);
+    QTest::newRow("between two") << qint64(201) << qint64(300) << QList<qint64>();
+    QTest::newRow("empty") << qint64(300) << qint64(300) << QList<qint64>();
+}
+
+void TestUserMeasurementDB::loadRange()
+{
+    QFETCH(qint64, from);
+    QFETCH(qint64, to);
+    QFETCH(QList<qint64>, expected);
+
+    Data::UserMeasurementList measurements;
+    QCOMPARE(Data::UserMeasurementDB::loadRange(TEST_USER, Data::Timestamp(from), Data::Timestamp(to), measurements), expected.size());
+    QCOMPARE(minutes(measurements), expected);
+    qDeleteAll(measurements);
+}
+
+void TestUserMeasurementDB::loadPage()
+{
+    // The pages go back from the newest measurement
+    Data::UserMeasurementList measurements;
+    QCOMPARE(Data::UserMeasurementDB::loadPage(TEST_USER, Data::Timestamp(), 3, measurements), 3);
+    QCOMPARE(Data::UserMeasurementDB::loadPage(TEST_USER, measurements.last()->getTimestamp(), 3, measurements), 1);
+    QCOMPARE(minutes(measurements), QList<qint64>() << 400 << 300 << 200 << 100);
+    qDeleteAll(measurements);
+}
+
+void TestUserMeasurementDB::rangeModel()
+{
+    // The range is shown from the newest measurement, all at once
+    Data::Models::UserMeasurementModel model(TEST_USER, Data::Timestamp(200), Data::Timestamp());
+    QCOMPARE(model.rowCount(), 3);
+    QVERIFY(!model.canFetchMore(QModelIndex()));
+    Data::UserMeasurementList shown;
+    for (int row = 0; row < model.rowCount(); ++row)
+        shown << static_cast<Data::UserMeasurement*>(model.index(row, 0).internalPointer());
+    QCOMPARE(minutes(shown), QList<qint64>() << 400 << 300 << 200);
+}
+
+QTEST_MAIN(TestUserMeasurementDB)
+#include "TestUserMeasurementDB.moc"
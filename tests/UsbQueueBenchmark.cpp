@@ -0,0 +1,110 @@
+/*!
+ * \file UsbQueueBenchmark.cpp
+ * \author agent <agent@local>
+ * \date 2026-10-16
+ * \brief Benchmark of the queue depth of the USB downloads
+ * \copyright 2026 (c) agent
+ *
+ *    This file is part of BeurerScaleManager.
+ *
+ *    BeurerScaleManager is free software: you can redistribute it and/or modify
+ *    it under the terms of the GNU General Public License as published by
+ *    the Free Software Foundation, either version 3 of the License, or
+ *    (at your option) any later version.
+ *
+ *    BeurerScaleManager is distributed in the hope that it will be useful,
+ *    but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *    GNU General Public License for more details.
+ *
+ *    You should have received a copy of the GNU General Public License
+ *    along with BeurerScaleManager.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <Usb/UsbDownloader.hpp>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QStringList>
+#include <QtCore/QTextStream>
+#include <QtCore/QtAlgorithms>
+
+//! Default number of downloads for each queue depth
+#define BENCHMARK_RUNS  5
+
+/*! Download the first scale some times with a queue depth.
+ * \param usb the downloader, with the transport selected by the environment
+ * \param depth the number of transfers in flight
+ * \param runs the number of downloads
+ * \param out the stream for the report
+ * \return the median time in ms of the downloads, \c -1 if all of them failed
+ */
+static qint64 measure(BSM::Usb::UsbDownloader& usb, const int depth, const int runs, QTextStream& out)
+{
+    QList<qint64> times;
+    usb.setQueueDepth(depth);
+    for (int i = 0; i < runs; ++i) {
+        // Without autoDownload the thread does a single download and exits
+        usb.requestDownload();
+        usb.wait();
+
+        qint64 time = usb.getDownloadTime();
+        if (time < 0) {
+            out << "depth " << usb.getQueueDepth() << " run " << (i + 1) << ": failed" << endl;
+            continue;
+        }
+        out << "depth " << usb.getQueueDepth() << " run " << (i + 1) << ": " << time << " ms" << endl;
+        times.append(time);
+    }
+
+    if (times.isEmpty())
+        return -1;
+    qSort(times);
+    return times.at(times.size() / 2);
+}
+
+/*! Starting point for the benchmark.
+ *
+ * Usage: \c UsbQueueBenchmark [depth] [runs]
+ *
+ * The first scale is downloaded \c runs times with a single transfer in
+ * flight, then \c runs times with \c depth transfers in flight (by default
+ * the queue depth of the application), and the medians are compared.
+ *
+ * The transport is selected as in the application: the real scales, or the
+ * capture file named by \c BSM_USB_REPLAY. \c BSM_USB_CAPTURE records the
+ * downloads, so a run on a scale can be played back later. The replay does
+ * not depend on the queue depth: it measures the cost of the downloader and
+ * the listener, and checks the benchmark itself without a scale.
+ * \param argc the number of command-line arguments
+ * \param argv the array of command-line arguments
+ * \return the exit status value: \c 0 if no errors
+ */
+int main(int argc, char** argv)
+{
+    QCoreApplication app(argc, argv);
+    QTextStream out(stdout);
+
+    BSM::Usb::UsbDownloader usb;
+    usb.setMode(BSM::Usb::UsbDownloader::FirstDevice);
+
+    QStringList args = app.arguments();
+    int depth = args.size() > 1 ? args.at(1).toInt() : usb.getQueueDepth();
+    int runs = args.size() > 2 ? args.at(2).toInt() : BENCHMARK_RUNS;
+    if (depth < 1 || runs < 1) {
+        out << "Usage: " << args.at(0) << " [depth] [runs]" << endl;
+        return 2;
+    }
+
+    qint64 single = measure(usb, 1, runs, out);
+    qint64 queued = measure(usb, depth, runs, out);
+    if (single < 0 || queued < 0) {
+        out << "No scale downloaded" << endl;
+        return 1;
+    }
+
+    out << "median with depth 1: " << single << " ms" << endl;
+    out << "median with depth " << usb.getQueueDepth() << ": " << queued << " ms" << endl;
+    if (queued > 0)
+        out << "speedup: " << QString::number((double) single / queued, 'f', 2) << endl;
+    return 0;
+}